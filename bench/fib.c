@@ -0,0 +1,14 @@
+// Benchmark: recursive Fibonacci (function calls, small stack frames)
+// expect: 46368
+
+int fib(int n) {
+    if (n <= 2) {
+        return 1;
+    } else {
+        return fib(n-1) + fib(n-2);
+    }
+}
+
+int main(int arg) {
+    return fib(24);
+}
@@ -0,0 +1,35 @@
+// Benchmark: integer matrix multiplication (2D arrays, nested loops)
+// expect: 1823534490
+
+#define N 32
+
+int a[N][N];
+int b[N][N];
+int c[N][N];
+
+int main(int arg) {
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            a[i][j] = (i * 7 + j * 3 + arg) % 17 - 8;
+            b[i][j] = (i * 5 + j * 11) % 13 - 6;
+        }
+    }
+    for (int round = 0; round < 4; round++) {
+        for (int i = 0; i < N; i++) {
+            for (int j = 0; j < N; j++) {
+                int sum = 0;
+                for (int k = 0; k < N; k++) {
+                    sum += a[i][k] * b[k][j];
+                }
+                c[i][j] = sum;
+            }
+        }
+    }
+    int checksum = 0;
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            checksum = checksum * 31 + c[i][j];
+        }
+    }
+    return checksum & 0x7FFFFFFF;
+}
@@ -0,0 +1,62 @@
+// Benchmark: n-body simulation (doubles, structs, square roots)
+// expect: 31860
+
+#define BODIES 5
+#define STEPS 2000
+
+struct body {
+    double x, y, z;
+    double vx, vy, vz;
+    double mass;
+};
+
+struct body bodies[BODIES] = {
+    {0, 0, 0, 0, 0, 0, 39.47},
+    {4.84, -1.16, -0.10, 0.61, 2.81, -0.02, 0.04},
+    {8.34, 4.12, -0.40, -1.01, 1.82, 0.01, 0.01},
+    {12.89, -15.11, -0.22, 1.08, 0.87, -0.01, 0.002},
+    {15.38, -25.92, 0.18, 0.98, 0.59, -0.03, 0.002},
+};
+
+// No libm needed: a few Newton steps from a rough guess
+double square_root(double v) {
+    double r = v > 1 ? v / 2 : 1;
+    for (int i = 0; i < 20; i++) {
+        r = (r + v / r) / 2;
+    }
+    return r;
+}
+
+void advance(double dt) {
+    for (int i = 0; i < BODIES; i++) {
+        for (int j = i + 1; j < BODIES; j++) {
+            double dx = bodies[i].x - bodies[j].x;
+            double dy = bodies[i].y - bodies[j].y;
+            double dz = bodies[i].z - bodies[j].z;
+            double d2 = dx * dx + dy * dy + dz * dz;
+            double mag = dt / (d2 * square_root(d2));
+            bodies[i].vx -= dx * bodies[j].mass * mag;
+            bodies[i].vy -= dy * bodies[j].mass * mag;
+            bodies[i].vz -= dz * bodies[j].mass * mag;
+            bodies[j].vx += dx * bodies[i].mass * mag;
+            bodies[j].vy += dy * bodies[i].mass * mag;
+            bodies[j].vz += dz * bodies[i].mass * mag;
+        }
+    }
+    for (int i = 0; i < BODIES; i++) {
+        bodies[i].x += dt * bodies[i].vx;
+        bodies[i].y += dt * bodies[i].vy;
+        bodies[i].z += dt * bodies[i].vz;
+    }
+}
+
+int main(int arg) {
+    for (int step = 0; step < STEPS; step++) {
+        advance(0.01);
+    }
+    double sum = 0;
+    for (int i = 0; i < BODIES; i++) {
+        sum += bodies[i].x + bodies[i].y + bodies[i].z;
+    }
+    return (int)(sum * 1000);
+}
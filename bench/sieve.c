@@ -0,0 +1,25 @@
+// Benchmark: sieve of Eratosthenes (byte array, tight loops)
+// expect: 1900
+
+#define N 16384
+
+char is_composite[N];
+
+int main(int arg) {
+    int count = 0;
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < N; i++) {
+            is_composite[i] = 0;
+        }
+        count = 0;
+        for (int i = 2; i < N; i++) {
+            if (!is_composite[i]) {
+                count++;
+                for (int j = 2 * i; j < N; j += i) {
+                    is_composite[j] = 1;
+                }
+            }
+        }
+    }
+    return count;
+}
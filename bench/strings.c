@@ -0,0 +1,65 @@
+// Benchmark: string processing (char pointers, copies, hashing)
+// expect: 329902528
+
+char text[] =
+    "the quick brown fox jumps over the lazy dog while the calculator "
+    "compiles a tiny c program and runs it from the heap of the app";
+
+char buffer[256];
+
+int length(const char *s) {
+    int n = 0;
+    while (s[n]) {
+        n++;
+    }
+    return n;
+}
+
+void reverse(char *s, int n) {
+    for (int i = 0, j = n - 1; i < j; i++, j--) {
+        char c = s[i];
+        s[i] = s[j];
+        s[j] = c;
+    }
+}
+
+// Reverse the whole string, then each word: the words end up in reverse order
+void reverse_words(char *s) {
+    int n = length(s);
+    reverse(s, n);
+    int start = 0;
+    for (int i = 0; i <= n; i++) {
+        if (s[i] == ' ' || s[i] == 0) {
+            reverse(s + start, i - start);
+            start = i + 1;
+        }
+    }
+}
+
+unsigned hash(const char *s) {
+    unsigned h = 2166136261u;
+    while (*s) {
+        h = (h ^ (unsigned char)*s++) * 16777619u;
+    }
+    return h;
+}
+
+int main(int arg) {
+    unsigned h = 0;
+    for (int round = 0; round < 500; round++) {
+        int n = length(text);
+        for (int i = 0; i <= n; i++) {
+            buffer[i] = text[i];
+        }
+        reverse_words(buffer);
+        int vowels = 0;
+        for (int i = 0; buffer[i]; i++) {
+            char c = buffer[i];
+            if (c == 'a' || c == 'e' || c == 'i' || c == 'o' || c == 'u') {
+                vowels++;
+            }
+        }
+        h = h * 31 + hash(buffer) + vowels;
+    }
+    return h & 0x7FFFFFFF;
+}
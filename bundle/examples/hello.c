@@ -0,0 +1,13 @@
+// This is NOT a Python script
+// This is a C program!
+
+#include <tcclib.h>
+#include <numworks.h>
+
+int main(int argc, char** argv) {
+    printf("%s\n", hello);
+    eadk_timing_msleep_int(1000);
+    printf("add(%d, %d) = %d\n", argc, 2 * argc, add(argc, 2 * argc));
+    eadk_timing_msleep_int(1000);
+    return 0;
+}
@@ -0,0 +1,19 @@
+// Random stars on the framebuffer, with the helper library
+
+#include <numworks.h>
+
+int main(int n) {
+    int w = fb_width();
+    int h = fb_height();
+    nw_srand(n);
+    fb_clear(fb_rgb(0, 0, 32));
+    for (int i = 0; i < 200; i++) {
+        int x = nw_rand_range(0, w - 1);
+        int y = nw_rand_range(0, h - 1);
+        int light = nw_rand_range(128, 255);
+        fb_pixel(x, y, fb_rgb(light, light, light));
+    }
+    fb_present();
+    eadk_timing_msleep_int(2000);
+    return nw_isqrt(w * h);
+}
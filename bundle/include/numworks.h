@@ -0,0 +1,42 @@
+/* Functions of the app that your program can call on the NumWorks calculator
+ *
+ *   #include <numworks.h>
+ *
+ * The fb_ functions draw in an off-screen framebuffer, sent to the screen by
+ * fb_present() (see src/framebuffer.h in the app). The nw_ functions come
+ * from lib/nwhelpers.c, compiled along with your program.
+ */
+#ifndef _NUMWORKS_H
+#define _NUMWORKS_H
+
+/* Exported by the app (src/jit_exports.c) */
+extern const char hello[];
+int add(int a, int b);
+void eadk_timing_msleep_int(int ms);
+
+typedef unsigned short fb_color_t;
+int fb_width(void);
+int fb_height(void);
+int fb_scale(void);
+fb_color_t fb_rgb(int r, int g, int b);
+void fb_clear(fb_color_t color);
+void fb_pixel(int x, int y, fb_color_t color);
+fb_color_t fb_get_pixel(int x, int y);
+void fb_fill_rect(int x, int y, int w, int h, fb_color_t color);
+void fb_rect(int x, int y, int w, int h, fb_color_t color);
+void fb_hline(int x, int y, int w, fb_color_t color);
+void fb_vline(int x, int y, int h, fb_color_t color);
+void fb_line(int x0, int y0, int x1, int y1, fb_color_t color);
+void fb_blit(int x, int y, int w, int h, const fb_color_t *pixels);
+void fb_present(void);
+
+/* Helper library (lib/nwhelpers.c) */
+int nw_min(int a, int b);
+int nw_max(int a, int b);
+int nw_clamp(int x, int low, int high);
+unsigned nw_isqrt(unsigned n);
+void nw_srand(unsigned seed);
+unsigned nw_rand(void);
+int nw_rand_range(int low, int high);
+
+#endif /* _NUMWORKS_H */
@@ -0,0 +1,62 @@
+/* Simple libc header for TCC, on the NumWorks calculator
+ *
+ * Self-contained version of tinycc's include/tcclib.h: there is no
+ * <stddef.h> or <stdarg.h> on the calculator, so the few types it needs are
+ * defined here. Each function declared here must also be given to TCC by
+ * src/jit_exports.c of the app, since nothing else links the compiled program
+ * with the C library: add it to both.
+ */
+#ifndef _TCCLIB_H
+#define _TCCLIB_H
+
+typedef __SIZE_TYPE__ size_t;
+typedef __PTRDIFF_TYPE__ ptrdiff_t;
+typedef __builtin_va_list va_list;
+#define va_start __builtin_va_start
+#define va_arg __builtin_va_arg
+#define va_end __builtin_va_end
+
+#define NULL ((void*)0)
+
+/* stdlib.h */
+void *calloc(size_t nmemb, size_t size);
+void *malloc(size_t size);
+void free(void *ptr);
+void *realloc(void *ptr, size_t size);
+int atoi(const char *nptr);
+long int strtol(const char *nptr, char **endptr, int base);
+unsigned long int strtoul(const char *nptr, char **endptr, int base);
+int abs(int j);
+void qsort(void *base, size_t nmemb, size_t size, int (*compar)(const void *, const void *));
+
+/* stdio.h */
+int printf(const char *format, ...);
+int sprintf(char *str, const char *format, ...);
+int snprintf(char *str, size_t size, const char *format, ...);
+int vsnprintf(char *str, size_t size, const char *format, va_list ap);
+int puts(const char *s);
+int putchar(int c);
+
+/* string.h */
+char *strcat(char *dest, const char *src);
+char *strchr(const char *s, int c);
+char *strrchr(const char *s, int c);
+char *strcpy(char *dest, const char *src);
+char *strncpy(char *dest, const char *src, size_t n);
+int strcmp(const char *s1, const char *s2);
+int strncmp(const char *s1, const char *s2, size_t n);
+size_t strlen(const char *s);
+void *memcpy(void *dest, const void *src, size_t n);
+void *memmove(void *dest, const void *src, size_t n);
+void *memset(void *s, int c, size_t n);
+int memcmp(const void *s1, const void *s2, size_t n);
+
+/* math.h */
+double sqrt(double x);
+double sin(double x);
+double cos(double x);
+double fabs(double x);
+double floor(double x);
+double pow(double x, double y);
+
+#endif /* _TCCLIB_H */
@@ -0,0 +1,55 @@
+/* Helper library, compiled by the app along with each program
+ * (declared in <numworks.h>)
+ */
+
+int nw_min(int a, int b) {
+    return a < b ? a : b;
+}
+
+int nw_max(int a, int b) {
+    return a > b ? a : b;
+}
+
+int nw_clamp(int x, int low, int high) {
+    return x < low ? low : x > high ? high : x;
+}
+
+/* Integer square root, without the FPU */
+unsigned nw_isqrt(unsigned n) {
+    unsigned root = 0;
+    unsigned bit = 1u << 30;
+    while (bit > n) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (n >= root + bit) {
+            n -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+/* xorshift32 pseudo-random numbers */
+static unsigned nw_rand_state = 2463534242u;
+
+void nw_srand(unsigned seed) {
+    nw_rand_state = seed ? seed : 2463534242u;
+}
+
+unsigned nw_rand(void) {
+    unsigned x = nw_rand_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    nw_rand_state = x;
+    return x;
+}
+
+/* In [low, high] */
+int nw_rand_range(int low, int high) {
+    return low + (int)(nw_rand() % (unsigned)(high - low + 1));
+}
@@ -0,0 +1,184 @@
+//
+// Read-only bundle in the external data of the app (see bundle.h)
+//
+#include "bundle.h"
+#include <errno.h>
+#include <stdio.h> // For SEEK_SET...
+#include <string.h>
+
+static const uint8_t * s_bundle = NULL;
+static const bundle_entry_t * s_bundle_entries = NULL;
+static uint32_t s_bundle_count = 0;
+
+typedef struct {
+  const char * content; // NULL when the descriptor is free
+  uint32_t length;
+  uint32_t position;
+} bundle_file_t;
+
+static bundle_file_t s_bundle_files[BUNDLE_MAX_OPEN];
+
+static const char * bundle_entry_name(const bundle_entry_t * entry) {
+  return (const char *)s_bundle + entry->name;
+}
+
+bool bundle_init(const void * data) {
+  s_bundle = NULL;
+  s_bundle_entries = NULL;
+  s_bundle_count = 0;
+  const bundle_header_t * header = data;
+  // The count is checked by dividing, since count * sizeof(bundle_entry_t) may
+  // overflow a 32-bit size_t
+  if (header == NULL || header->magic != BUNDLE_MAGIC || header->version != BUNDLE_VERSION ||
+      header->size < sizeof(bundle_header_t) ||
+      header->count > (header->size - sizeof(bundle_header_t)) / sizeof(bundle_entry_t)) {
+    return false;
+  }
+  // Every name and content must lie in the bundle, with its NUL, and the names
+  // must be sorted without duplicates for bundle_lookup()
+  const uint8_t * bytes = data;
+  const bundle_entry_t * entries = (const bundle_entry_t *)(header + 1);
+  for (uint32_t i = 0; i < header->count; i++) {
+    if (entries[i].name >= header->size || entries[i].data > header->size ||
+        entries[i].length >= header->size - entries[i].data ||
+        memchr(bytes + entries[i].name, '\0', header->size - entries[i].name) == NULL ||
+        bytes[entries[i].data + entries[i].length] != '\0') {
+      return false;
+    }
+    if (i > 0 && strcmp((const char *)bytes + entries[i - 1].name, (const char *)bytes + entries[i].name) >= 0) {
+      return false;
+    }
+  }
+  s_bundle = data;
+  s_bundle_entries = entries;
+  s_bundle_count = header->count;
+  return true;
+}
+
+bool bundle_ready(void) {
+  return s_bundle != NULL;
+}
+
+static const bundle_entry_t * bundle_lookup(const char * name) {
+  // Binary search in the sorted names
+  uint32_t low = 0;
+  uint32_t high = s_bundle_count;
+  while (low < high) {
+    uint32_t middle = low + (high - low) / 2;
+    int order = strcmp(name, bundle_entry_name(&s_bundle_entries[middle]));
+    if (order == 0) {
+      return &s_bundle_entries[middle];
+    }
+    if (order < 0) {
+      high = middle;
+    } else {
+      low = middle + 1;
+    }
+  }
+  return NULL;
+}
+
+const char * bundle_find(const char * name, size_t * length) {
+  const bundle_entry_t * entry = bundle_lookup(name);
+  if (entry == NULL) {
+    return NULL;
+  }
+  if (length != NULL) {
+    *length = entry->length;
+  }
+  return (const char *)s_bundle + entry->data;
+}
+
+int bundle_count(void) {
+  return s_bundle_count;
+}
+
+const char * bundle_name(int index) {
+  return index >= 0 && (uint32_t)index < s_bundle_count ? bundle_entry_name(&s_bundle_entries[index]) : NULL;
+}
+
+//
+// File descriptors
+//
+
+bool bundle_is_fd(int fd) {
+  return fd >= BUNDLE_FD_BASE && fd < BUNDLE_FD_BASE + BUNDLE_MAX_OPEN;
+}
+
+static bundle_file_t * bundle_file(int fd) {
+  if (!bundle_is_fd(fd) || s_bundle_files[fd - BUNDLE_FD_BASE].content == NULL) {
+    errno = EBADF;
+    return NULL;
+  }
+  return &s_bundle_files[fd - BUNDLE_FD_BASE];
+}
+
+int bundle_open(const char * path) {
+  size_t mount_length = strlen(BUNDLE_MOUNT);
+  const bundle_entry_t * entry = NULL;
+  if (strncmp(path, BUNDLE_MOUNT, mount_length) == 0) {
+    // TCC may join the include path and the name with extra slashes
+    char name[BUNDLE_NAME_SIZE];
+    size_t length = 0;
+    for (path += mount_length; *path != '\0' && length + 1 < sizeof(name); path++) {
+      if (*path != '/' || (length > 0 && name[length - 1] != '/')) {
+        name[length++] = *path;
+      }
+    }
+    name[length] = '\0';
+    entry = *path == '\0' ? bundle_lookup(name) : NULL;
+  }
+  if (entry == NULL) {
+    errno = ENOENT;
+    return -1;
+  }
+  const char * content = (const char *)s_bundle + entry->data;
+  size_t length = entry->length;
+  for (int i = 0; i < BUNDLE_MAX_OPEN; i++) {
+    if (s_bundle_files[i].content == NULL) {
+      s_bundle_files[i].content = content;
+      s_bundle_files[i].length = length;
+      s_bundle_files[i].position = 0;
+      return BUNDLE_FD_BASE + i;
+    }
+  }
+  errno = EMFILE;
+  return -1;
+}
+
+int bundle_read(int fd, void * buffer, size_t size) {
+  bundle_file_t * file = bundle_file(fd);
+  if (file == NULL) {
+    return -1;
+  }
+  size_t left = file->length - file->position;
+  if (size > left) {
+    size = left;
+  }
+  memcpy(buffer, file->content + file->position, size);
+  file->position += size;
+  return (int)size;
+}
+
+long bundle_lseek(int fd, long offset, int whence) {
+  bundle_file_t * file = bundle_file(fd);
+  if (file == NULL) {
+    return -1;
+  }
+  long base = whence == SEEK_CUR ? (long)file->position : whence == SEEK_END ? (long)file->length : 0;
+  if (base + offset < 0 || base + offset > (long)file->length) {
+    errno = EINVAL;
+    return -1;
+  }
+  file->position = base + offset;
+  return file->position;
+}
+
+int bundle_close(int fd) {
+  bundle_file_t * file = bundle_file(fd);
+  if (file == NULL) {
+    return -1;
+  }
+  file->content = NULL;
+  return 0;
+}
@@ -0,0 +1,87 @@
+//
+// Read-only bundle of headers, library sources and examples, in the external
+// data of the app
+//
+// The bundle is built on the computer by `mkbundle` (src/host/mkbundle.c) from
+// the bundle/ folder, and installed along with the app by nwlink. It's used
+// where it lies: bundle_find() returns a pointer into it, so a source can be
+// given to tcc_compile_string() without any copy, and the #include of the
+// compiled program are read from it (see the _open() and _read() of
+// crt_stubs.c) instead of storage records.
+//
+// Layout (little-endian, offsets from the start of the bundle):
+//
+//   bundle_header_t
+//   bundle_entry_t[count], sorted by name
+//   names and contents, each one NUL-terminated
+//
+#ifndef BUNDLE_H
+#define BUNDLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define BUNDLE_MAGIC 0x444E424Eu // "NBND"
+#define BUNDLE_VERSION 1
+
+// Paths under this prefix are looked up in the bundle by _open()
+#define BUNDLE_MOUNT "/bundle/"
+// Include path of the bundle, to give to tcc_add_sysinclude_path()
+#define BUNDLE_INCLUDE_PATH BUNDLE_MOUNT "include"
+// Helper library compiled along with each program, if it's in the bundle
+#define BUNDLE_HELPERS "lib/nwhelpers.c"
+
+// Longest path of a file in the bundle
+#define BUNDLE_NAME_SIZE 128
+
+// Files opened at once, and the first of their file descriptors (far from
+// the real ones on the host)
+#define BUNDLE_MAX_OPEN 8
+#ifdef NUMWORKS_HOST
+#define BUNDLE_FD_BASE 1000
+#else
+#define BUNDLE_FD_BASE 16
+#endif
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t count;
+  uint32_t size; // Of the whole bundle, in bytes
+} bundle_header_t;
+
+typedef struct {
+  uint32_t name;   // Offset of the name
+  uint32_t data;   // Offset of the content
+  uint32_t length; // Of the content, without its NUL
+} bundle_entry_t;
+
+// Use the bundle at `data`: returns false (and no bundle) if it's not a valid one
+bool bundle_init(const void * data);
+bool bundle_ready(void);
+
+// Content of the file `name` (like "include/tcclib.h"), NUL-terminated, and
+// its length in `length` if not NULL. NULL if it's not in the bundle.
+const char * bundle_find(const char * name, size_t * length);
+
+int bundle_count(void);
+const char * bundle_name(int index);
+
+// File descriptors on the files of the bundle, for the newlib syscalls
+// (path starts with BUNDLE_MOUNT), -1 with errno set on errors
+int bundle_open(const char * path);
+int bundle_read(int fd, void * buffer, size_t size);
+long bundle_lseek(int fd, long offset, int whence);
+int bundle_close(int fd);
+bool bundle_is_fd(int fd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
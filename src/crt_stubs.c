@@ -1,5 +1,8 @@
 /* src/crt_stubs.c */
 #include <stddef.h>
+#include "mem_pool.h"
+#include "bundle.h"
+#include <errno.h>
 
 extern char end;
 
@@ -9,11 +12,10 @@ void _init(void) {}
 // extern void _fini(void) {}
 __attribute__((used)) void _fini(void) { }
 
+// newlib's malloc grows from the low end of the memory pool (see mem_pool.h),
+// and fails instead of running into the TCC heap or the stack
 void * _sbrk(ptrdiff_t incr) {
-    static char *heap = &end;
-    char *prev = heap;
-    heap += incr;
-    return prev;
+    return mem_pool_sbrk(incr);
 }
 
 extern char _eadk_external_data_start[];
@@ -21,3 +23,36 @@ extern char _eadk_external_data_start[];
 void * get_eadk_data(void) {
     return _eadk_external_data_start;
 }
+
+// File syscalls of newlib, for the files of the bundle only (see bundle.h):
+// this is how TCC reads the #include of the compiled program.
+// Everything else fails, like the libnosys stubs these replace.
+int _open(const char * path, int flags, int mode) {
+    (void)flags;
+    (void)mode;
+    return bundle_open(path);
+}
+
+int _read(int fd, void * buffer, size_t size) {
+    if (!bundle_is_fd(fd)) {
+        errno = ENOSYS;
+        return -1;
+    }
+    return bundle_read(fd, buffer, size);
+}
+
+long _lseek(int fd, long offset, int whence) {
+    if (!bundle_is_fd(fd)) {
+        errno = ENOSYS;
+        return -1;
+    }
+    return bundle_lseek(fd, offset, whence);
+}
+
+int _close(int fd) {
+    if (!bundle_is_fd(fd)) {
+        errno = ENOSYS;
+        return -1;
+    }
+    return bundle_close(fd);
+}
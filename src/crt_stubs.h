@@ -14,3 +14,9 @@ void * _sbrk(ptrdiff_t incr);
 extern char _eadk_external_data_start[];
 
 void * get_eadk_data(void);
+
+// Read the files of the bundle (see bundle.h)
+int _open(const char * path, int flags, int mode);
+int _read(int fd, void * buffer, size_t size);
+long _lseek(int fd, long offset, int whence);
+int _close(int fd);
@@ -0,0 +1,333 @@
+//
+// Off-screen framebuffer with dirty-rectangle push (see framebuffer.h)
+//
+#include "framebuffer.h"
+#include "mem_pool.h"
+#include <eadk.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Staging buffer used to send the scaled (or non contiguous) rows of a dirty
+// rectangle to the display: one full logical row at the coarsest scale
+#define FB_STAGING_PIXELS (FB_SCREEN_WIDTH * 4)
+
+typedef struct {
+  int x0, y0, x1, y1; // x1 and y1 are exclusive
+} fb_box_t;
+
+static fb_color_t * s_fb_pixels = NULL;
+static void * s_fb_allocated = NULL; // By fb_init_from_pool()
+static int s_fb_width = 0;
+static int s_fb_height = 0;
+static int s_fb_scale = 0;
+
+static fb_box_t s_fb_dirty[FB_MAX_DIRTY_RECTS];
+static int s_fb_dirty_count = 0;
+
+static fb_color_t s_fb_staging[FB_STAGING_PIXELS];
+static fb_stats_t s_fb_stats;
+
+bool fb_init(void * buffer, size_t size) {
+  static const int scales[] = {1, 2, 4};
+  for (size_t i = 0; i < sizeof(scales) / sizeof(scales[0]); i++) {
+    int w = FB_SCREEN_WIDTH / scales[i];
+    int h = FB_SCREEN_HEIGHT / scales[i];
+    if ((size_t)w * h * sizeof(fb_color_t) <= size) {
+      s_fb_pixels = (fb_color_t *)buffer;
+      s_fb_width = w;
+      s_fb_height = h;
+      s_fb_scale = scales[i];
+      s_fb_dirty_count = 0;
+      memset(&s_fb_stats, 0, sizeof(s_fb_stats));
+      return true;
+    }
+  }
+  s_fb_pixels = NULL;
+  s_fb_width = s_fb_height = s_fb_scale = 0;
+  return false;
+}
+
+bool fb_init_from_pool(void) {
+  fb_release();
+  // The newlib heap takes it from the low end of the pool
+  size_t budget = mem_pool_free() / FB_POOL_SHARE;
+  for (int scale = 1; scale <= 4; scale *= 2) {
+    size_t size = (size_t)(FB_SCREEN_WIDTH / scale) * (FB_SCREEN_HEIGHT / scale) * sizeof(fb_color_t);
+    if (size <= budget) {
+      s_fb_allocated = malloc(size);
+      if (s_fb_allocated != NULL) {
+        return fb_init(s_fb_allocated, size);
+      }
+    }
+  }
+  return fb_init(NULL, 0);
+}
+
+void fb_release(void) {
+  if (s_fb_allocated != NULL) {
+    if (s_fb_pixels == s_fb_allocated) {
+      fb_init(NULL, 0);
+    }
+    free(s_fb_allocated);
+    s_fb_allocated = NULL;
+  }
+}
+
+int fb_width(void) { return s_fb_width; }
+int fb_height(void) { return s_fb_height; }
+int fb_scale(void) { return s_fb_scale; }
+
+fb_color_t fb_rgb(int r, int g, int b) {
+  return (fb_color_t)(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | ((b & 0xF8) >> 3));
+}
+
+static int fb_box_area(const fb_box_t * b) {
+  return (b->x1 - b->x0) * (b->y1 - b->y0);
+}
+
+static fb_box_t fb_box_union(const fb_box_t * a, const fb_box_t * b) {
+  fb_box_t u;
+  u.x0 = a->x0 < b->x0 ? a->x0 : b->x0;
+  u.y0 = a->y0 < b->y0 ? a->y0 : b->y0;
+  u.x1 = a->x1 > b->x1 ? a->x1 : b->x1;
+  u.y1 = a->y1 > b->y1 ? a->y1 : b->y1;
+  return u;
+}
+
+// Overlapping or touching boxes are always merged: pushing their union costs
+// less than two pushes of the shared edge
+static bool fb_box_touch(const fb_box_t * a, const fb_box_t * b) {
+  return a->x0 <= b->x1 && b->x0 <= a->x1 && a->y0 <= b->y1 && b->y0 <= a->y1;
+}
+
+static void fb_box_remove(int index) {
+  s_fb_dirty[index] = s_fb_dirty[--s_fb_dirty_count];
+}
+
+static void fb_mark_dirty(int x0, int y0, int x1, int y1) {
+  if (x0 < 0) x0 = 0;
+  if (y0 < 0) y0 = 0;
+  if (x1 > s_fb_width) x1 = s_fb_width;
+  if (y1 > s_fb_height) y1 = s_fb_height;
+  if (x0 >= x1 || y0 >= y1) {
+    return;
+  }
+  fb_box_t box = {x0, y0, x1, y1};
+
+  for (;;) {
+    int i;
+    for (i = 0; i < s_fb_dirty_count; i++) {
+      if (fb_box_touch(&box, &s_fb_dirty[i])) {
+        break;
+      }
+    }
+    if (i < s_fb_dirty_count) {
+      box = fb_box_union(&box, &s_fb_dirty[i]);
+      fb_box_remove(i);
+      continue;
+    }
+    if (s_fb_dirty_count < FB_MAX_DIRTY_RECTS) {
+      s_fb_dirty[s_fb_dirty_count++] = box;
+      return;
+    }
+    // Full: fold the new box into the one it grows the least, and retry since
+    // the union may now touch other boxes
+    int best = 0;
+    int best_growth = 0;
+    for (i = 0; i < s_fb_dirty_count; i++) {
+      fb_box_t u = fb_box_union(&box, &s_fb_dirty[i]);
+      int growth = fb_box_area(&u) - fb_box_area(&s_fb_dirty[i]);
+      if (i == 0 || growth < best_growth) {
+        best = i;
+        best_growth = growth;
+      }
+    }
+    box = fb_box_union(&box, &s_fb_dirty[best]);
+    fb_box_remove(best);
+  }
+}
+
+void fb_clear(fb_color_t color) {
+  if (!s_fb_pixels) {
+    return;
+  }
+  int count = s_fb_width * s_fb_height;
+  for (int i = 0; i < count; i++) {
+    s_fb_pixels[i] = color;
+  }
+  s_fb_dirty_count = 0;
+  fb_mark_dirty(0, 0, s_fb_width, s_fb_height);
+}
+
+void fb_pixel(int x, int y, fb_color_t color) {
+  if (!s_fb_pixels || x < 0 || y < 0 || x >= s_fb_width || y >= s_fb_height) {
+    return;
+  }
+  s_fb_pixels[y * s_fb_width + x] = color;
+  fb_mark_dirty(x, y, x + 1, y + 1);
+}
+
+fb_color_t fb_get_pixel(int x, int y) {
+  if (!s_fb_pixels || x < 0 || y < 0 || x >= s_fb_width || y >= s_fb_height) {
+    return 0;
+  }
+  return s_fb_pixels[y * s_fb_width + x];
+}
+
+void fb_fill_rect(int x, int y, int w, int h, fb_color_t color) {
+  if (!s_fb_pixels) {
+    return;
+  }
+  int x0 = x < 0 ? 0 : x;
+  int y0 = y < 0 ? 0 : y;
+  int x1 = x + w > s_fb_width ? s_fb_width : x + w;
+  int y1 = y + h > s_fb_height ? s_fb_height : y + h;
+  if (x0 >= x1 || y0 >= y1) {
+    return;
+  }
+  for (int j = y0; j < y1; j++) {
+    fb_color_t * row = s_fb_pixels + j * s_fb_width;
+    for (int i = x0; i < x1; i++) {
+      row[i] = color;
+    }
+  }
+  fb_mark_dirty(x0, y0, x1, y1);
+}
+
+void fb_hline(int x, int y, int w, fb_color_t color) {
+  fb_fill_rect(x, y, w, 1, color);
+}
+
+void fb_vline(int x, int y, int h, fb_color_t color) {
+  fb_fill_rect(x, y, 1, h, color);
+}
+
+void fb_rect(int x, int y, int w, int h, fb_color_t color) {
+  if (w <= 0 || h <= 0) {
+    return;
+  }
+  fb_hline(x, y, w, color);
+  fb_hline(x, y + h - 1, w, color);
+  fb_vline(x, y, h, color);
+  fb_vline(x + w - 1, y, h, color);
+}
+
+// Bresenham, with a single dirty rectangle for the whole segment
+void fb_line(int x0, int y0, int x1, int y1, fb_color_t color) {
+  if (!s_fb_pixels) {
+    return;
+  }
+  int dx = x1 > x0 ? x1 - x0 : x0 - x1;
+  int dy = y1 > y0 ? y0 - y1 : y1 - y0;
+  int sx = x0 < x1 ? 1 : -1;
+  int sy = y0 < y1 ? 1 : -1;
+  int err = dx + dy;
+
+  fb_mark_dirty(x0 < x1 ? x0 : x1, y0 < y1 ? y0 : y1,
+                (x0 > x1 ? x0 : x1) + 1, (y0 > y1 ? y0 : y1) + 1);
+
+  for (;;) {
+    if (x0 >= 0 && y0 >= 0 && x0 < s_fb_width && y0 < s_fb_height) {
+      s_fb_pixels[y0 * s_fb_width + x0] = color;
+    }
+    if (x0 == x1 && y0 == y1) {
+      break;
+    }
+    int e2 = 2 * err;
+    if (e2 >= dy) {
+      err += dy;
+      x0 += sx;
+    }
+    if (e2 <= dx) {
+      err += dx;
+      y0 += sy;
+    }
+  }
+}
+
+void fb_blit(int x, int y, int w, int h, const fb_color_t * pixels) {
+  if (!s_fb_pixels || !pixels) {
+    return;
+  }
+  int x0 = x < 0 ? 0 : x;
+  int y0 = y < 0 ? 0 : y;
+  int x1 = x + w > s_fb_width ? s_fb_width : x + w;
+  int y1 = y + h > s_fb_height ? s_fb_height : y + h;
+  if (x0 >= x1 || y0 >= y1) {
+    return;
+  }
+  for (int j = y0; j < y1; j++) {
+    memcpy(s_fb_pixels + j * s_fb_width + x0,
+           pixels + (j - y) * w + (x0 - x),
+           (x1 - x0) * sizeof(fb_color_t));
+  }
+  fb_mark_dirty(x0, y0, x1, y1);
+}
+
+static void fb_push(int x, int y, int w, int h, const fb_color_t * pixels) {
+  eadk_rect_t rect = {(uint16_t)x, (uint16_t)y, (uint16_t)w, (uint16_t)h};
+  eadk_display_push_rect(rect, pixels);
+  s_fb_stats.rects_pushed++;
+  s_fb_stats.pixels_pushed += w * h;
+}
+
+static void fb_present_box(const fb_box_t * box) {
+  const int scale = s_fb_scale;
+  const int w = box->x1 - box->x0;
+  const int screen_w = w * scale;
+
+  // Full width rows at scale 1 are already contiguous in the framebuffer
+  if (scale == 1 && w == s_fb_width) {
+    fb_push(0, box->y0, w, box->y1 - box->y0, s_fb_pixels + box->y0 * s_fb_width);
+    return;
+  }
+
+  const int rows_per_push = FB_STAGING_PIXELS / (screen_w * scale);
+  for (int y = box->y0; y < box->y1; y += rows_per_push) {
+    int rows = box->y1 - y < rows_per_push ? box->y1 - y : rows_per_push;
+    fb_color_t * out = s_fb_staging;
+    for (int j = 0; j < rows; j++) {
+      const fb_color_t * in = s_fb_pixels + (y + j) * s_fb_width + box->x0;
+      fb_color_t * line = out;
+      for (int i = 0; i < w; i++) {
+        for (int k = 0; k < scale; k++) {
+          *out++ = in[i];
+        }
+      }
+      // Repeat the scaled line for the other screen rows of this logical row
+      for (int k = 1; k < scale; k++) {
+        memcpy(out, line, screen_w * sizeof(fb_color_t));
+        out += screen_w;
+      }
+    }
+    fb_push(box->x0 * scale, y * scale, screen_w, rows * scale, s_fb_staging);
+  }
+}
+
+void fb_present(void) {
+  if (!s_fb_pixels) {
+    return;
+  }
+  // When most of the screen changed, a single full push beats many partial ones
+  int dirty_area = 0;
+  for (int i = 0; i < s_fb_dirty_count; i++) {
+    dirty_area += fb_box_area(&s_fb_dirty[i]);
+  }
+  if (dirty_area >= s_fb_width * s_fb_height * 3 / 4) {
+    fb_box_t full = {0, 0, s_fb_width, s_fb_height};
+    s_fb_dirty[0] = full;
+    s_fb_dirty_count = 1;
+  }
+  for (int i = 0; i < s_fb_dirty_count; i++) {
+    fb_present_box(&s_fb_dirty[i]);
+  }
+  s_fb_dirty_count = 0;
+  s_fb_stats.frames++;
+#ifdef NUMWORKS_HOST
+  eadk_host_frame_done();
+#endif
+}
+
+void fb_get_stats(fb_stats_t * stats) {
+  *stats = s_fb_stats;
+}
@@ -0,0 +1,78 @@
+//
+// Off-screen framebuffer for the programs compiled by TCC
+//
+// Drawing goes to an RGB565 buffer in RAM, and fb_present() only pushes the
+// rectangles that changed since the last frame to the display. This way a
+// user loop drawing pixel by pixel never pays the EADK call cost per pixel.
+//
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define FB_SCREEN_WIDTH 320
+#define FB_SCREEN_HEIGHT 240
+
+// RAM given to the framebuffer by fb_init_from_pool(): at most this fraction
+// (1/FB_POOL_SHARE) of the free RAM of the pool, the rest being left to the
+// compiled program and to TCC. With less than a full screen (150 KB), a
+// coarser scale is picked: 160x120 (38 KB) or 80x60 (9.5 KB) logical pixels,
+// each drawn as a 2x2 or 4x4 block on screen.
+#ifndef FB_POOL_SHARE
+#define FB_POOL_SHARE 2
+#endif
+
+// Above this many dirty rectangles, the two closest ones get merged
+#define FB_MAX_DIRTY_RECTS 8
+
+typedef uint16_t fb_color_t;
+
+typedef struct {
+  uint32_t frames;        // Number of calls to fb_present()
+  uint32_t rects_pushed;  // Number of eadk_display_push_rect() calls
+  uint32_t pixels_pushed; // Number of screen pixels sent to the display
+} fb_stats_t;
+
+// Use `size` bytes at `buffer` as the framebuffer. Returns false if even the
+// coarsest scale does not fit.
+bool fb_init(void * buffer, size_t size);
+
+// Allocate the framebuffer from the pool (see mem_pool.h), at the finest scale
+// that fits, and use it. Returns false if even the coarsest scale does not fit.
+bool fb_init_from_pool(void);
+// Free the buffer allocated by fb_init_from_pool(), if any
+void fb_release(void);
+
+// Logical size of the framebuffer (depends on the scale chosen by fb_init)
+int fb_width(void);
+int fb_height(void);
+int fb_scale(void);
+
+fb_color_t fb_rgb(int r, int g, int b);
+
+void fb_clear(fb_color_t color);
+void fb_pixel(int x, int y, fb_color_t color);
+fb_color_t fb_get_pixel(int x, int y);
+void fb_fill_rect(int x, int y, int w, int h, fb_color_t color);
+void fb_rect(int x, int y, int w, int h, fb_color_t color);
+void fb_hline(int x, int y, int w, fb_color_t color);
+void fb_vline(int x, int y, int h, fb_color_t color);
+void fb_line(int x0, int y0, int x1, int y1, fb_color_t color);
+void fb_blit(int x, int y, int w, int h, const fb_color_t * pixels);
+
+// Push the dirty rectangles to the display
+void fb_present(void);
+
+void fb_get_stats(fb_stats_t * stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
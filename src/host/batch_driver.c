@@ -0,0 +1,209 @@
+//
+// Host batch driver: compile and run a directory of C programs on all cores
+//
+// libtcc keeps global state (and so does our TCC heap in tcc_stubs.c), so the
+// workers are processes rather than threads: each program gets a fresh fork
+// with its own heap and TCC state, and a crashing program only takes its own
+// worker down.
+//
+// Usage: batch_driver [-j JOBS] [--budget MS] [-v] directory_or_file.c...
+//
+#include "host_compile.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define BATCH_PATH_SIZE 512
+
+typedef struct {
+  char path[BATCH_PATH_SIZE];
+  pid_t pid;
+  int pipe_fd;
+  bool done;
+  host_result_t result;
+  char status[16]; // result.status points into the worker, so it's copied here
+} batch_job_t;
+
+static batch_job_t * s_jobs = NULL;
+static int s_job_count = 0;
+static int s_job_capacity = 0;
+
+static void batch_add_job(const char * path) {
+  if (s_job_count == s_job_capacity) {
+    s_job_capacity = s_job_capacity ? 2 * s_job_capacity : 64;
+    s_jobs = realloc(s_jobs, s_job_capacity * sizeof(batch_job_t));
+    if (s_jobs == NULL) {
+      fprintf(stderr, "Out of memory\n");
+      exit(2);
+    }
+  }
+  batch_job_t * job = &s_jobs[s_job_count++];
+  memset(job, 0, sizeof(*job));
+  snprintf(job->path, sizeof(job->path), "%s", path);
+  job->pipe_fd = -1;
+}
+
+static int batch_compare_paths(const void * a, const void * b) {
+  return strcmp(((const batch_job_t *)a)->path, ((const batch_job_t *)b)->path);
+}
+
+static bool batch_has_c_extension(const char * name) {
+  size_t length = strlen(name);
+  return length > 2 && strcmp(name + length - 2, ".c") == 0;
+}
+
+// Add `path` if it's a file, or all the .c files in it if it's a directory
+static void batch_collect(const char * path) {
+  DIR * dir = opendir(path);
+  if (dir == NULL) {
+    batch_add_job(path);
+    return;
+  }
+  int first = s_job_count;
+  struct dirent * entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (batch_has_c_extension(entry->d_name)) {
+      char file[BATCH_PATH_SIZE];
+      snprintf(file, sizeof(file), "%s/%s", path, entry->d_name);
+      batch_add_job(file);
+    }
+  }
+  closedir(dir);
+  qsort(s_jobs + first, s_job_count - first, sizeof(batch_job_t), batch_compare_paths);
+}
+
+// In the worker: compile and run, then send the result back through the pipe
+static void batch_worker(const char * path, int fd, bool verbose) {
+  if (!verbose) {
+    int null_fd = open("/dev/null", O_WRONLY);
+    if (null_fd >= 0) {
+      dup2(null_fd, STDOUT_FILENO);
+      close(null_fd);
+    }
+  }
+  host_result_t result;
+  char * source = host_read_file(path);
+  if (source == NULL) {
+    memset(&result, 0, sizeof(result));
+    result.status = "missing";
+  } else {
+    host_compile_and_run(source, 42, &result);
+  }
+  ssize_t written = write(fd, &result, sizeof(result));
+  _exit(written == (ssize_t)sizeof(result) ? 0 : 1);
+}
+
+static bool batch_start(batch_job_t * job, bool verbose) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    return false;
+  }
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid < 0) {
+    close(fds[0]);
+    close(fds[1]);
+    return false;
+  }
+  if (pid == 0) {
+    close(fds[0]);
+    batch_worker(job->path, fds[1], verbose);
+  }
+  close(fds[1]);
+  job->pid = pid;
+  job->pipe_fd = fds[0];
+  return true;
+}
+
+static void batch_finish(batch_job_t * job, int wait_status) {
+  const char * status = "crash";
+  if (WIFEXITED(wait_status) && WEXITSTATUS(wait_status) == 0 &&
+      read(job->pipe_fd, &job->result, sizeof(job->result)) == (ssize_t)sizeof(job->result)) {
+    // The status strings are literals of host_compile.c, at the same address in the fork
+    status = job->result.status;
+  } else {
+    memset(&job->result, 0, sizeof(job->result));
+    if (WIFSIGNALED(wait_status)) {
+      snprintf(job->result.error, sizeof(job->result.error), "killed by signal %d", WTERMSIG(wait_status));
+    }
+  }
+  snprintf(job->status, sizeof(job->status), "%s", status);
+  job->result.status = NULL;
+  close(job->pipe_fd);
+  job->pipe_fd = -1;
+  job->done = true;
+}
+
+int main(int argc, char ** argv) {
+  int jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  bool verbose = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+      jobs = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--budget") == 0 && i + 1 < argc) {
+      runner_set_budget_ms((uint32_t)atoi(argv[++i]));
+    } else if (strcmp(argv[i], "-v") == 0) {
+      verbose = true;
+    } else {
+      batch_collect(argv[i]);
+    }
+  }
+  if (s_job_count == 0) {
+    fprintf(stderr, "Usage: %s [-j JOBS] [--budget MS] [-v] directory_or_file.c...\n", argv[0]);
+    return 2;
+  }
+  if (jobs < 1) {
+    jobs = 1;
+  }
+
+  double start = host_now_ms();
+  int next = 0;
+  int running = 0;
+  while (next < s_job_count || running > 0) {
+    while (running < jobs && next < s_job_count) {
+      if (!batch_start(&s_jobs[next], verbose)) {
+        fprintf(stderr, "Couldn't start a worker for '%s'\n", s_jobs[next].path);
+        snprintf(s_jobs[next].status, sizeof(s_jobs[next].status), "no-worker");
+        s_jobs[next].done = true;
+      } else {
+        running++;
+      }
+      next++;
+    }
+    int wait_status;
+    pid_t pid = waitpid(-1, &wait_status, 0);
+    if (pid < 0) {
+      break;
+    }
+    for (int i = 0; i < next; i++) {
+      if (!s_jobs[i].done && s_jobs[i].pid == pid) {
+        batch_finish(&s_jobs[i], wait_status);
+        running--;
+        break;
+      }
+    }
+  }
+  double elapsed_ms = host_now_ms() - start;
+
+  int passed = 0;
+  double compile_ms = 0;
+  printf("program,status,compile_ms,heap_peak,run_ms,ret,error\n");
+  for (int i = 0; i < s_job_count; i++) {
+    const batch_job_t * job = &s_jobs[i];
+    const host_result_t * r = &job->result;
+    printf("%s,%s,%.3f,%zu,%.3f,%d,\"%s\"\n", job->path, job->status, r->compile_ms, r->heap_peak,
+           r->run.wall_us / 1e3, r->ret, r->error);
+    passed += strcmp(job->status, "ok") == 0;
+    compile_ms += r->compile_ms;
+  }
+  fprintf(stderr, "%d/%d ok, %d jobs, %.0f ms wall, %.1f programs/s, %.0f ms of compilation\n",
+          passed, s_job_count, jobs, elapsed_ms,
+          elapsed_ms > 0 ? s_job_count * 1e3 / elapsed_ms : 0.0, compile_ms);
+  free(s_jobs);
+  return passed == s_job_count ? 0 : 1;
+}
@@ -0,0 +1,192 @@
+//
+// Host benchmark harness for the programs of bench/
+//
+// For each program: compile latency, TCC heap peak, image size, runtime and
+// result, as CSV. With --baseline, compares against a CSV saved from an
+// earlier run and exits with 1 if anything regressed beyond the tolerance.
+//
+// Usage: bench_harness [--repeat N] [--tolerance PCT] [--baseline FILE]
+//                      [--output FILE] program.c...
+//
+#include "host_compile.h"
+#include "tcc_stubs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_MAX_PROGRAMS 64
+#define BENCH_NAME_SIZE 64
+
+// Differences below these are noise, whatever the tolerance
+#define BENCH_MIN_DELTA_MS 0.05
+#define BENCH_MIN_DELTA_BYTES 64
+
+typedef struct {
+  char name[BENCH_NAME_SIZE];
+  char status[16];
+  double compile_ms;
+  size_t heap_peak;
+  size_t image_size;
+  double run_ms;
+  unsigned long long cycles;
+  size_t stack_peak;
+  int ret;
+} bench_row_t;
+
+static const char * s_csv_header = "program,status,compile_ms,heap_peak,image_bytes,run_ms,cycles,stack_peak,ret";
+
+static void bench_program_name(const char * path, char * name) {
+  const char * base = strrchr(path, '/');
+  base = base ? base + 1 : path;
+  snprintf(name, BENCH_NAME_SIZE, "%s", base);
+  char * dot = strrchr(name, '.');
+  if (dot) {
+    *dot = '\0';
+  }
+}
+
+static void bench_print_row(FILE * f, const bench_row_t * row) {
+  fprintf(f, "%s,%s,%.3f,%zu,%zu,%.3f,%llu,%zu,%d\n", row->name, row->status, row->compile_ms,
+          row->heap_peak, row->image_size, row->run_ms, row->cycles, row->stack_peak, row->ret);
+}
+
+static int bench_read_csv(const char * path, bench_row_t * rows, int max_rows) {
+  FILE * f = fopen(path, "r");
+  if (f == NULL) {
+    return -1;
+  }
+  char line[512];
+  int count = 0;
+  while (count < max_rows && fgets(line, sizeof(line), f)) {
+    bench_row_t * row = &rows[count];
+    if (sscanf(line, "%63[^,],%15[^,],%lf,%zu,%zu,%lf,%llu,%zu,%d", row->name, row->status,
+               &row->compile_ms, &row->heap_peak, &row->image_size, &row->run_ms, &row->cycles,
+               &row->stack_peak, &row->ret) == 9) {
+      count++;
+    }
+  }
+  fclose(f);
+  return count;
+}
+
+static bool bench_regressed(double base, double value, double tolerance, double min_delta) {
+  return value - base > min_delta && value > base * (1 + tolerance / 100);
+}
+
+// Print the regressions of `row` against `base`, and return how many there are
+static int bench_compare(const bench_row_t * base, const bench_row_t * row, double tolerance) {
+  int regressions = 0;
+  if (strcmp(base->status, "ok") == 0 && strcmp(row->status, "ok") != 0) {
+    fprintf(stderr, "REGRESSION %s: status %s -> %s\n", row->name, base->status, row->status);
+    regressions++;
+  }
+#define BENCH_CHECK(field, min_delta, format)                                          \
+  if (bench_regressed((double)base->field, (double)row->field, tolerance, min_delta)) { \
+    fprintf(stderr, "REGRESSION %s: " #field " " format " -> " format "\n", row->name,  \
+            base->field, row->field);                                                  \
+    regressions++;                                                                     \
+  }
+  BENCH_CHECK(compile_ms, BENCH_MIN_DELTA_MS, "%.3f")
+  BENCH_CHECK(heap_peak, BENCH_MIN_DELTA_BYTES, "%zu")
+  BENCH_CHECK(image_size, BENCH_MIN_DELTA_BYTES, "%zu")
+  BENCH_CHECK(run_ms, BENCH_MIN_DELTA_MS, "%.3f")
+#undef BENCH_CHECK
+  return regressions;
+}
+
+int main(int argc, char ** argv) {
+  int repeat = 5;
+  double tolerance = 10;
+  const char * baseline_path = NULL;
+  const char * output_path = NULL;
+  const char * programs[BENCH_MAX_PROGRAMS];
+  int program_count = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+      repeat = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+      tolerance = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+      baseline_path = argv[++i];
+    } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+      output_path = argv[++i];
+    } else if (program_count < BENCH_MAX_PROGRAMS) {
+      programs[program_count++] = argv[i];
+    }
+  }
+  if (program_count == 0 || repeat < 1) {
+    fprintf(stderr, "Usage: %s [--repeat N] [--tolerance PCT] [--baseline FILE] [--output FILE] program.c...\n", argv[0]);
+    return 2;
+  }
+
+  bench_row_t baseline[BENCH_MAX_PROGRAMS];
+  int baseline_count = 0;
+  if (baseline_path != NULL) {
+    baseline_count = bench_read_csv(baseline_path, baseline, BENCH_MAX_PROGRAMS);
+    if (baseline_count < 0) {
+      fprintf(stderr, "Couldn't read baseline '%s'\n", baseline_path);
+      return 2;
+    }
+  }
+
+  FILE * out = stdout;
+  if (output_path != NULL && (out = fopen(output_path, "w")) == NULL) {
+    fprintf(stderr, "Couldn't write '%s'\n", output_path);
+    return 2;
+  }
+  fprintf(out, "%s\n", s_csv_header);
+
+  int regressions = 0;
+  for (int p = 0; p < program_count; p++) {
+    bench_row_t row;
+    memset(&row, 0, sizeof(row));
+    bench_program_name(programs[p], row.name);
+
+    char * source = host_read_file(programs[p]);
+    if (source == NULL) {
+      fprintf(stderr, "Couldn't read '%s'\n", programs[p]);
+      snprintf(row.status, sizeof(row.status), "missing");
+      bench_print_row(out, &row);
+      continue;
+    }
+
+    // Keep the fastest of the repeated runs, sizes don't change between them
+    for (int r = 0; r < repeat; r++) {
+      host_result_t result;
+      host_compile_and_run(source, 42, &result);
+      double run_ms = result.run.wall_us / 1e3;
+      if (r == 0 || result.compile_ms < row.compile_ms) {
+        row.compile_ms = result.compile_ms;
+      }
+      if (r == 0 || run_ms < row.run_ms) {
+        row.run_ms = run_ms;
+        row.cycles = result.run.cycles;
+      }
+      snprintf(row.status, sizeof(row.status), "%s", result.status);
+      row.heap_peak = result.heap_peak;
+      row.image_size = result.image_size;
+      row.stack_peak = result.run.stack_peak;
+      row.ret = result.ret;
+      if (result.error[0] != '\0') {
+        fprintf(stderr, "%s: %s\n", row.name, result.error);
+      }
+    }
+    free(source);
+    bench_print_row(out, &row);
+
+    for (int b = 0; b < baseline_count; b++) {
+      if (strcmp(baseline[b].name, row.name) == 0) {
+        regressions += bench_compare(&baseline[b], &row, tolerance);
+      }
+    }
+  }
+
+  if (out != stdout) {
+    fclose(out);
+  }
+  if (baseline_path != NULL) {
+    fprintf(stderr, "%d regression(s) against '%s' (tolerance %.0f%%)\n", regressions, baseline_path, tolerance);
+  }
+  return regressions == 0 ? 0 : 1;
+}
@@ -0,0 +1,60 @@
+//
+// Pack files into a bundle (see bundle_build.h)
+//
+#include "bundle_build.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int bundle_build_compare(const void * a, const void * b) {
+  return strcmp(((const bundle_source_t *)a)->name, ((const bundle_source_t *)b)->name);
+}
+
+uint8_t * bundle_build(bundle_source_t * files, uint32_t count, size_t * size) {
+  // bundle_find() does a binary search, in strcmp() order
+  qsort(files, count, sizeof(bundle_source_t), bundle_build_compare);
+
+  size_t total = sizeof(bundle_header_t) + count * sizeof(bundle_entry_t);
+  for (uint32_t i = 0; i < count; i++) {
+    total += strlen(files[i].name) + 1 + files[i].length + 1;
+  }
+  total = (total + 3) & ~(size_t)3;
+  uint8_t * bundle = calloc(1, total);
+  if (bundle == NULL) {
+    return NULL;
+  }
+  bundle_header_t * header = (bundle_header_t *)bundle;
+  header->magic = BUNDLE_MAGIC;
+  header->version = BUNDLE_VERSION;
+  header->count = count;
+  header->size = (uint32_t)total;
+
+  bundle_entry_t * entries = (bundle_entry_t *)(header + 1);
+  size_t offset = sizeof(bundle_header_t) + count * sizeof(bundle_entry_t);
+  for (uint32_t i = 0; i < count; i++) {
+    entries[i].name = (uint32_t)offset;
+    memcpy(bundle + offset, files[i].name, strlen(files[i].name) + 1);
+    offset += strlen(files[i].name) + 1;
+    entries[i].data = (uint32_t)offset;
+    entries[i].length = (uint32_t)files[i].length;
+    memcpy(bundle + offset, files[i].content, files[i].length);
+    offset += files[i].length + 1;
+  }
+
+  // Every file must be found back, with the same content
+  bool valid = bundle_init(bundle);
+  for (uint32_t i = 0; valid && i < count; i++) {
+    size_t length = 0;
+    const char * content = bundle_find(files[i].name, &length);
+    if (content == NULL || length != files[i].length || memcmp(content, files[i].content, length) != 0) {
+      fprintf(stderr, "'%s' isn't found back in the bundle\n", files[i].name);
+      valid = false;
+    }
+  }
+  if (!valid) {
+    free(bundle);
+    return NULL;
+  }
+  *size = total;
+  return bundle;
+}
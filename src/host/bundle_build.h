@@ -0,0 +1,20 @@
+//
+// Pack files into a bundle (see bundle.h), for mkbundle and the host benchmarks
+//
+#ifndef BUNDLE_BUILD_H
+#define BUNDLE_BUILD_H
+
+#include "bundle.h"
+
+typedef struct {
+  char name[BUNDLE_NAME_SIZE]; // Like "include/tcclib.h"
+  const char * content;        // NUL-terminated
+  size_t length;
+} bundle_source_t;
+
+// Sort `files` by name and pack them, then check that each one is found back
+// with bundle_find() (this leaves the new bundle in use). Returns the bundle,
+// to free with free(), and its size in `size`, or NULL on errors.
+uint8_t * bundle_build(bundle_source_t * files, uint32_t count, size_t * size);
+
+#endif
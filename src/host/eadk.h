@@ -0,0 +1,67 @@
+//
+// Host stand-in for the <eadk.h> header provided by nwlink
+//
+// Only declares the part of the EADK used by this app, with the same names
+// and types, so that the sources build unchanged on a computer with
+// -DNUMWORKS_HOST. The fake implementation lives in eadk_host.c.
+//
+#ifndef EADK_H
+#define EADK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Display
+
+typedef uint16_t eadk_color_t;
+
+typedef struct {
+  uint16_t x;
+  uint16_t y;
+} eadk_point_t;
+
+typedef struct {
+  uint16_t x;
+  uint16_t y;
+  uint16_t width;
+  uint16_t height;
+} eadk_rect_t;
+
+static const eadk_rect_t eadk_screen_rect = {0, 0, 320, 240};
+
+void eadk_display_push_rect(eadk_rect_t rect, const eadk_color_t * pixels);
+void eadk_display_push_rect_uniform(eadk_rect_t rect, eadk_color_t color);
+void eadk_display_pull_rect(eadk_rect_t rect, eadk_color_t * pixels);
+bool eadk_display_wait_for_vblank();
+
+// Timing
+
+void eadk_timing_usleep(uint32_t us);
+void eadk_timing_msleep(uint32_t ms);
+uint64_t eadk_timing_millis();
+
+// Misc
+
+uint32_t eadk_random();
+
+// Host only: called by fb_present() at the end of each frame. When the
+// NWA_HOST_FRAME_DIR environment variable is set, each frame is dumped there
+// as frame_NNNNN.ppm.
+void eadk_host_frame_done(void);
+
+// Host only: write the current content of the fake screen as a binary PPM
+bool eadk_host_dump_ppm(const char * path);
+
+// Host only: the fake screen, 320x240 RGB565 pixels, row by row
+const eadk_color_t * eadk_host_screen(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,116 @@
+//
+// Fake EADK for host builds (see eadk.h in this folder)
+//
+// The display is a 320x240 RGB565 array in RAM, and sleeps are skipped unless
+// NWA_HOST_SLEEP is set, so that the debug pauses of the app don't slow down
+// host runs and benchmarks.
+//
+#include <eadk.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SCREEN_WIDTH 320
+#define SCREEN_HEIGHT 240
+
+static eadk_color_t s_screen[SCREEN_WIDTH * SCREEN_HEIGHT];
+static unsigned s_frame_index = 0;
+
+static bool host_rect_is_valid(eadk_rect_t rect) {
+  return rect.x + rect.width <= SCREEN_WIDTH && rect.y + rect.height <= SCREEN_HEIGHT;
+}
+
+void eadk_display_push_rect(eadk_rect_t rect, const eadk_color_t * pixels) {
+  if (!host_rect_is_valid(rect)) {
+    fprintf(stderr, "eadk_display_push_rect: rect out of screen\n");
+    abort();
+  }
+  for (int j = 0; j < rect.height; j++) {
+    memcpy(&s_screen[(rect.y + j) * SCREEN_WIDTH + rect.x], pixels + j * rect.width,
+           rect.width * sizeof(eadk_color_t));
+  }
+}
+
+void eadk_display_push_rect_uniform(eadk_rect_t rect, eadk_color_t color) {
+  if (!host_rect_is_valid(rect)) {
+    fprintf(stderr, "eadk_display_push_rect_uniform: rect out of screen\n");
+    abort();
+  }
+  for (int j = 0; j < rect.height; j++) {
+    for (int i = 0; i < rect.width; i++) {
+      s_screen[(rect.y + j) * SCREEN_WIDTH + rect.x + i] = color;
+    }
+  }
+}
+
+void eadk_display_pull_rect(eadk_rect_t rect, eadk_color_t * pixels) {
+  if (!host_rect_is_valid(rect)) {
+    fprintf(stderr, "eadk_display_pull_rect: rect out of screen\n");
+    abort();
+  }
+  for (int j = 0; j < rect.height; j++) {
+    memcpy(pixels + j * rect.width, &s_screen[(rect.y + j) * SCREEN_WIDTH + rect.x],
+           rect.width * sizeof(eadk_color_t));
+  }
+}
+
+bool eadk_display_wait_for_vblank() {
+  return true;
+}
+
+void eadk_timing_usleep(uint32_t us) {
+  if (getenv("NWA_HOST_SLEEP") == NULL) {
+    return;
+  }
+  struct timespec ts = {us / 1000000, (us % 1000000) * 1000};
+  nanosleep(&ts, NULL);
+}
+
+void eadk_timing_msleep(uint32_t ms) {
+  eadk_timing_usleep(ms * 1000);
+}
+
+uint64_t eadk_timing_millis() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+uint32_t eadk_random() {
+  return ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+}
+
+void eadk_host_frame_done(void) {
+  const char * dir = getenv("NWA_HOST_FRAME_DIR");
+  if (dir == NULL) {
+    return;
+  }
+  char path[512];
+  snprintf(path, sizeof(path), "%s/frame_%05u.ppm", dir, s_frame_index++);
+  if (!eadk_host_dump_ppm(path)) {
+    fprintf(stderr, "Couldn't write '%s'\n", path);
+  }
+}
+
+bool eadk_host_dump_ppm(const char * path) {
+  FILE * f = fopen(path, "wb");
+  if (f == NULL) {
+    return false;
+  }
+  fprintf(f, "P6\n%d %d\n255\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+  for (int i = 0; i < SCREEN_WIDTH * SCREEN_HEIGHT; i++) {
+    eadk_color_t c = s_screen[i];
+    unsigned char rgb[3] = {
+      (unsigned char)(((c >> 11) & 0x1F) * 255 / 31),
+      (unsigned char)(((c >> 5) & 0x3F) * 255 / 63),
+      (unsigned char)((c & 0x1F) * 255 / 31),
+    };
+    fwrite(rgb, 1, sizeof(rgb), f);
+  }
+  return fclose(f) == 0;
+}
+
+const eadk_color_t * eadk_host_screen(void) {
+  return s_screen;
+}
@@ -0,0 +1,144 @@
+//
+// Host frame-rate benchmark for the off-screen framebuffer (framebuffer.c)
+//
+// Runs a few drawing scenes at each scale, checks that the fake screen matches
+// the framebuffer after every scene, and prints one CSV line per run. Then
+// checks the scale fb_init_from_pool() picks for a few sizes of the pool.
+// Set NWA_HOST_FRAME_DIR to also get every frame as a PPM file.
+//
+// Usage: fb_bench [frames]
+//
+#include <eadk.h>
+#include "framebuffer.h"
+#include "mem_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static fb_color_t s_buffer[FB_SCREEN_WIDTH * FB_SCREEN_HEIGHT];
+
+static double now_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void scene_clear(int frame) {
+  fb_clear(fb_rgb(frame * 8, 255 - frame * 4, frame * 2));
+  fb_present();
+}
+
+static void scene_sprite(int frame) {
+  const int size = 16;
+  int x = (frame * 3) % (fb_width() - size);
+  int y = (frame * 2) % (fb_height() - size);
+  if (frame == 0) {
+    fb_clear(0);
+  } else {
+    int px = ((frame - 1) * 3) % (fb_width() - size);
+    int py = ((frame - 1) * 2) % (fb_height() - size);
+    fb_fill_rect(px, py, size, size, 0);
+  }
+  fb_fill_rect(x, y, size, size, fb_rgb(255, 200, 0));
+  fb_present();
+}
+
+static void scene_lines(int frame) {
+  for (int i = 0; i < 8; i++) {
+    fb_line(eadk_random() % fb_width(), eadk_random() % fb_height(),
+            eadk_random() % fb_width(), eadk_random() % fb_height(),
+            (fb_color_t)(frame * 31 + i * 1024));
+  }
+  fb_present();
+}
+
+static void scene_pixels(int frame) {
+  for (int i = 0; i < 500; i++) {
+    fb_pixel(eadk_random() % fb_width(), eadk_random() % fb_height(), (fb_color_t)(frame + i));
+  }
+  fb_present();
+}
+
+static bool screen_matches_framebuffer(void) {
+  const eadk_color_t * screen = eadk_host_screen();
+  const int scale = fb_scale();
+  for (int y = 0; y < fb_height() * scale; y++) {
+    for (int x = 0; x < fb_width() * scale; x++) {
+      if (screen[y * FB_SCREEN_WIDTH + x] != fb_get_pixel(x / scale, y / scale)) {
+        fprintf(stderr, "Mismatch at (%d, %d)\n", x, y);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+int main(int argc, char ** argv) {
+  int frames = argc > 1 ? atoi(argv[1]) : 200;
+  static const struct {
+    const char * name;
+    void (*draw)(int frame);
+  } scenes[] = {
+    {"clear", scene_clear},
+    {"sprite", scene_sprite},
+    {"lines", scene_lines},
+    {"pixels", scene_pixels},
+  };
+  static const size_t sizes[] = {
+    FB_SCREEN_WIDTH * FB_SCREEN_HEIGHT * 2,
+    FB_SCREEN_WIDTH * FB_SCREEN_HEIGHT / 2,
+    FB_SCREEN_WIDTH * FB_SCREEN_HEIGHT / 8,
+  };
+
+  int failures = 0;
+  printf("scene,scale,frames,seconds,fps,rects_per_frame,pixels_per_frame\n");
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    for (size_t i = 0; i < sizeof(scenes) / sizeof(scenes[0]); i++) {
+      if (!fb_init(s_buffer, sizes[s])) {
+        fprintf(stderr, "fb_init(%zu) failed\n", sizes[s]);
+        return 1;
+      }
+      fb_clear(0);
+      fb_present();
+      srand(1);
+
+      fb_stats_t before;
+      fb_get_stats(&before);
+      double start = now_seconds();
+      for (int frame = 0; frame < frames; frame++) {
+        scenes[i].draw(frame);
+      }
+      double elapsed = now_seconds() - start;
+      fb_stats_t after;
+      fb_get_stats(&after);
+
+      if (!screen_matches_framebuffer()) {
+        fprintf(stderr, "Scene '%s' at scale %d: screen differs from framebuffer\n",
+                scenes[i].name, fb_scale());
+        failures++;
+      }
+      int n = after.frames - before.frames;
+      printf("%s,%d,%d,%.6f,%.1f,%.2f,%.0f\n", scenes[i].name, fb_scale(), n, elapsed,
+             elapsed > 0 ? n / elapsed : 0.0,
+             (double)(after.rects_pushed - before.rects_pushed) / n,
+             (double)(after.pixels_pushed - before.pixels_pushed) / n);
+    }
+  }
+
+  // Free RAM of the pool (in KB) and the scale expected, 0 for none
+  static const struct {
+    size_t pool_kb;
+    int scale;
+  } pools[] = {{400, 1}, {200, 2}, {40, 4}, {8, 0}};
+  static uint8_t s_pool[400 * 1024];
+  for (size_t p = 0; p < sizeof(pools) / sizeof(pools[0]); p++) {
+    mem_pool_init_region(s_pool, pools[p].pool_kb * 1024);
+    bool ok = fb_init_from_pool();
+    if (fb_scale() != pools[p].scale || ok != (pools[p].scale != 0)) {
+      fprintf(stderr, "Pool of %zuKB: scale %d instead of %d\n", pools[p].pool_kb, fb_scale(), pools[p].scale);
+      failures++;
+    }
+    fb_release();
+  }
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,415 @@
+//
+// Footprint of the app: flash and RAM taken by each object and by each part
+// of libtcc, from the map file written by the linker
+//
+// Flash holds .text, .rodata and the initial values of .data; RAM holds .data
+// and .bss, and whatever they take is missing from the TCC heap (see
+// mem_pool.h). With LTO, the code of the app comes from the link-time objects
+// of GCC, so `make footprint LTO=0` gives the breakdown per source file.
+//
+// Each part of libtcc is found from the name of its archive member (tccpp.o,
+// tccgen.o...), or when libtcc is built as one source (libtcc.o), from the name
+// of the function of each input section: this needs -ffunction-sections (see
+// `make libtcc-small`), and is only a best guess from naming conventions.
+//
+// Usage: footprint [--top N] tiny-c-compiler.map
+//
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FOOTPRINT_LINE_SIZE 1024
+#define FOOTPRINT_NAME_SIZE 256
+#define FOOTPRINT_MAX_GROUPS 256
+
+typedef enum {
+  FOOTPRINT_TEXT,
+  FOOTPRINT_RODATA,
+  FOOTPRINT_DATA,
+  FOOTPRINT_BSS,
+  FOOTPRINT_KIND_COUNT,
+} footprint_kind_t;
+
+typedef struct {
+  char name[FOOTPRINT_NAME_SIZE];
+  unsigned long size[FOOTPRINT_KIND_COUNT];
+} footprint_group_t;
+
+typedef struct {
+  footprint_group_t groups[FOOTPRINT_MAX_GROUPS];
+  int count;
+} footprint_table_t;
+
+static footprint_table_t s_objects;
+static footprint_table_t s_features;
+
+// Parts of libtcc, by archive member
+static const char * const s_member_features[][2] = {
+  {"libtcc.o", "driver (libtcc.c)"},
+  {"tccpp.o", "preprocessor"},
+  {"tccgen.o", "front end (tccgen.c)"},
+  {"arm-gen.o", "ARM backend"},
+  {"arm-link.o", "ARM relocations"},
+  {"arm-asm.o", "assembler"},
+  {"tccasm.o", "assembler"},
+  {"tccelf.o", "ELF linker and output"},
+  {"tccrun.o", "run time (relocate, backtrace)"},
+  {"tccdbg.o", "debug info"},
+  {"tcctools.o", "tools (ar, impdef)"},
+  {"bcheck.o", "bounds checking"},
+  {"i386-gen.o", "other backends"},
+  {"x86_64-gen.o", "other backends"},
+  {"arm64-gen.o", "other backends"},
+  {"riscv64-gen.o", "other backends"},
+  {"c67-gen.o", "other backends"},
+  {"tccpe.o", "other backends"},
+  {"tccmacho.o", "other backends"},
+  {"tcccoff.o", "other backends"},
+};
+
+// Parts of libtcc, by function name when it's all in libtcc.o. The first match
+// wins, and a name ending with '*' is a prefix.
+static const char * const s_function_features[][2] = {
+  {"o", "ARM backend"},
+  {"load", "ARM backend"},
+  {"store", "ARM backend"},
+  {"gsym_addr", "ARM backend"},
+  {"gjmp*", "ARM backend"},
+  {"gtst*", "ARM backend"},
+  {"gfunc_*", "ARM backend"},
+  {"gen_op*", "ARM backend"},
+  {"gen_cvt*", "ARM backend"},
+  {"gen_le32", "ARM backend"},
+  {"gen_fill_nops", "ARM backend"},
+  {"gen_vla_*", "ARM backend"},
+  {"ggoto", "ARM backend"},
+  {"arm_*", "ARM backend"},
+  {"stuff_const*", "ARM backend"},
+  {"encbranch", "ARM backend"},
+  {"decbranch", "ARM backend"},
+  {"intr", "ARM backend"},
+  {"vfpr", "ARM backend"},
+  {"relocate", "ARM relocations"},
+  {"code_reloc", "ARM relocations"},
+  {"gotplt_entry_type", "ARM relocations"},
+  {"create_plt_entry", "ARM relocations"},
+  {"asm_*", "assembler"},
+  {"tcc_assemble*", "assembler"},
+  {"subst_asm_operand*", "assembler"},
+  {"parse_asm_*", "assembler"},
+  {"gen_expr32", "assembler"},
+  {"tcc_debug_*", "debug info"},
+  {"tcc_eh_*", "debug info"},
+  {"tcc_tcov_*", "debug info"},
+  {"dwarf_*", "debug info"},
+  {"tcc_relocate*", "run time (relocate, backtrace)"},
+  {"tcc_run*", "run time (relocate, backtrace)"},
+  {"rt_*", "run time (relocate, backtrace)"},
+  {"*backtrace*", "run time (relocate, backtrace)"},
+  {"set_pages_executable", "run time (relocate, backtrace)"},
+  {"elf_*", "ELF linker and output"},
+  {"put_elf_*", "ELF linker and output"},
+  {"new_section", "ELF linker and output"},
+  {"section_*", "ELF linker and output"},
+  {"tccelf_*", "ELF linker and output"},
+  {"relocate_*", "ELF linker and output"},
+  {"build_got*", "ELF linker and output"},
+  {"fill_got*", "ELF linker and output"},
+  {"*_elf_*", "ELF linker and output"},
+  {"tcc_output_*", "ELF linker and output"},
+  {"tcc_load_*", "ELF linker and output"},
+  {"tcc_add_runtime", "ELF linker and output"},
+  {"tcc_add_linker_symbols", "ELF linker and output"},
+  {"layout_sections", "ELF linker and output"},
+  {"alloc_sec_names", "ELF linker and output"},
+  {"sort_syms", "ELF linker and output"},
+  {"squeeze_multi_relocs", "ELF linker and output"},
+  {"tok_*", "preprocessor"},
+  {"next*", "preprocessor"},
+  {"macro_*", "preprocessor"},
+  {"*preprocess*", "preprocessor"},
+  {"parse_define", "preprocessor"},
+  {"define_*", "preprocessor"},
+  {"tccpp_*", "preprocessor"},
+  {"tcc_open*", "preprocessor"},
+  {"tcc_close", "preprocessor"},
+  {"unget_tok", "preprocessor"},
+  {"begin_macro", "preprocessor"},
+  {"end_macro", "preprocessor"},
+  {"get_tok_str", "preprocessor"},
+  {"skip", "preprocessor"},
+  {"cstr_*", "preprocessor"},
+  {"tal_*", "preprocessor"},
+  {"parse_number", "preprocessor"},
+  {"gen_*", "front end (tccgen.c)"},
+  {"gv*", "front end (tccgen.c)"},
+  {"vpush*", "front end (tccgen.c)"},
+  {"vset*", "front end (tccgen.c)"},
+  {"vpop", "front end (tccgen.c)"},
+  {"vstore", "front end (tccgen.c)"},
+  {"vswap", "front end (tccgen.c)"},
+  {"vrot*", "front end (tccgen.c)"},
+  {"decl*", "front end (tccgen.c)"},
+  {"unary*", "front end (tccgen.c)"},
+  {"expr_*", "front end (tccgen.c)"},
+  {"parse_*", "front end (tccgen.c)"},
+  {"type_*", "front end (tccgen.c)"},
+  {"sym_*", "front end (tccgen.c)"},
+  {"struct_*", "front end (tccgen.c)"},
+  {"block", "front end (tccgen.c)"},
+  {"tccgen_*", "front end (tccgen.c)"},
+  {"init_*", "front end (tccgen.c)"},
+  {"save_reg*", "front end (tccgen.c)"},
+  {"get_reg*", "front end (tccgen.c)"},
+  {"tcc_*", "driver (libtcc.c)"},
+  {"_tcc_*", "driver (libtcc.c)"},
+  {"dynarray_*", "driver (libtcc.c)"},
+  {"pstr*", "driver (libtcc.c)"},
+};
+
+static unsigned long s_total[FOOTPRINT_KIND_COUNT];
+
+static bool footprint_matches(const char * pattern, const char * name) {
+  size_t length = strlen(pattern);
+  if (pattern[0] == '*' && pattern[length - 1] == '*') {
+    char middle[FOOTPRINT_NAME_SIZE];
+    snprintf(middle, sizeof(middle), "%.*s", (int)(length - 2), pattern + 1);
+    return strstr(name, middle) != NULL;
+  }
+  if (pattern[length - 1] == '*') {
+    return strncmp(pattern, name, length - 1) == 0;
+  }
+  return strcmp(pattern, name) == 0;
+}
+
+static void footprint_add(footprint_table_t * table, const char * name, footprint_kind_t kind, unsigned long size) {
+  footprint_group_t * group = NULL;
+  for (int i = 0; i < table->count; i++) {
+    if (strcmp(table->groups[i].name, name) == 0) {
+      group = &table->groups[i];
+      break;
+    }
+  }
+  if (group == NULL) {
+    // The last group takes whatever doesn't fit
+    group = &table->groups[table->count < FOOTPRINT_MAX_GROUPS ? table->count++ : FOOTPRINT_MAX_GROUPS - 1];
+    if (group->name[0] == '\0') {
+      snprintf(group->name, sizeof(group->name), "%s", name);
+    }
+  }
+  group->size[kind] += size;
+}
+
+static bool footprint_kind(const char * section, footprint_kind_t * kind) {
+  if (strncmp(section, ".text", 5) == 0 || strncmp(section, ".glue_7", 7) == 0 || strncmp(section, ".vfp11_veneer", 13) == 0) {
+    *kind = FOOTPRINT_TEXT;
+  } else if (strncmp(section, ".rodata", 7) == 0 || strncmp(section, ".ARM.ex", 7) == 0 ||
+             strncmp(section, ".init_array", 11) == 0 || strncmp(section, ".fini_array", 11) == 0) {
+    *kind = FOOTPRINT_RODATA;
+  } else if (strncmp(section, ".data", 5) == 0) {
+    *kind = FOOTPRINT_DATA;
+  } else if (strncmp(section, ".bss", 4) == 0 || strcmp(section, "COMMON") == 0) {
+    *kind = FOOTPRINT_BSS;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// ".text.unlikely.foo.constprop.0" -> "foo"
+static void footprint_function_name(const char * section, char * name, size_t size) {
+  const char * start = strchr(section + 1, '.');
+  start = start != NULL ? start + 1 : "";
+  static const char * const prefixes[] = {"unlikely.", "startup.", "hot.", "exit.", "rel.", "str1."};
+  for (size_t i = 0; i < sizeof(prefixes) / sizeof(prefixes[0]); i++) {
+    if (strncmp(start, prefixes[i], strlen(prefixes[i])) == 0) {
+      start += strlen(prefixes[i]);
+    }
+  }
+  snprintf(name, size, "%s", start);
+  char * suffix = strchr(name, '.');
+  if (suffix != NULL) {
+    *suffix = '\0';
+  }
+}
+
+static const char * footprint_feature(const char * member, const char * section) {
+  if (strcmp(member, "libtcc.o") == 0) {
+    char function[FOOTPRINT_NAME_SIZE];
+    footprint_function_name(section, function, sizeof(function));
+    if (function[0] != '\0') {
+      for (size_t i = 0; i < sizeof(s_function_features) / sizeof(s_function_features[0]); i++) {
+        if (footprint_matches(s_function_features[i][0], function)) {
+          return s_function_features[i][1];
+        }
+      }
+      return "other (libtcc.c)";
+    }
+  }
+  for (size_t i = 0; i < sizeof(s_member_features) / sizeof(s_member_features[0]); i++) {
+    if (strcmp(member, s_member_features[i][0]) == 0) {
+      return s_member_features[i][1];
+    }
+  }
+  return "other";
+}
+
+// "path/to/libfoo.a(bar.o)" -> "libfoo.a(bar.o)", "/tmp/ccX.ltrans0.ltrans.o" -> "(LTO)"
+static void footprint_object_name(const char * path, char * name, size_t size) {
+  if (strstr(path, ".ltrans") != NULL) {
+    snprintf(name, size, "app code after LTO");
+    return;
+  }
+  const char * archive_end = strchr(path, '(');
+  const char * base = path;
+  for (const char * c = path; *c != '\0' && (archive_end == NULL || c < archive_end); c++) {
+    if (*c == '/') {
+      base = c + 1;
+    }
+  }
+  snprintf(name, size, "%s", base);
+}
+
+static void footprint_input(const char * section, unsigned long size, const char * object) {
+  footprint_kind_t kind;
+  if (size == 0 || !footprint_kind(section, &kind)) {
+    return;
+  }
+  char name[FOOTPRINT_NAME_SIZE];
+  footprint_object_name(object, name, sizeof(name));
+  footprint_add(&s_objects, name, kind, size);
+  s_total[kind] += size;
+
+  const char * member = strchr(object, '(');
+  if (member != NULL && strstr(object, "libtcc") != NULL) {
+    char member_name[FOOTPRINT_NAME_SIZE];
+    snprintf(member_name, sizeof(member_name), "%s", member + 1);
+    char * end = strchr(member_name, ')');
+    if (end != NULL) {
+      *end = '\0';
+    }
+    footprint_add(&s_features, footprint_feature(member_name, section), kind, size);
+  }
+}
+
+// Read the "Linker script and memory map" part of a GNU ld map file. Input
+// sections look like " .text.foo  0xADDRESS  0xSIZE  object", with the name
+// on a line of its own when it's long.
+static bool footprint_parse(const char * path) {
+  FILE * map = fopen(path, "r");
+  if (map == NULL) {
+    fprintf(stderr, "Couldn't open '%s'\n", path);
+    return false;
+  }
+  char line[FOOTPRINT_LINE_SIZE];
+  char pending[FOOTPRINT_NAME_SIZE] = "";
+  bool in_map = false;
+  while (fgets(line, sizeof(line), map) != NULL) {
+    line[strcspn(line, "\r\n")] = '\0';
+    if (!in_map) {
+      in_map = strncmp(line, "Linker script and memory map", 28) == 0;
+      continue;
+    }
+    if (strncmp(line, "/DISCARD/", 9) == 0) {
+      break;
+    }
+    char section[FOOTPRINT_NAME_SIZE];
+    unsigned long address, size;
+    int object_start = 0;
+    if (line[0] == ' ' && line[1] != ' ' && line[1] != '*') {
+      // Input section, maybe with its address on the next line
+      if (sscanf(line, " %255s 0x%lx 0x%lx %n", section, &address, &size, &object_start) == 3 && object_start > 0) {
+        footprint_input(section, size, line + object_start);
+        pending[0] = '\0';
+      } else if (sscanf(line, " %255s", section) == 1 && strchr(line + 1, ' ') == NULL) {
+        snprintf(pending, sizeof(pending), "%s", section);
+      }
+    } else if (pending[0] != '\0') {
+      if (sscanf(line, " 0x%lx 0x%lx %n", &address, &size, &object_start) == 2 && object_start > 0) {
+        footprint_input(pending, size, line + object_start);
+      }
+      pending[0] = '\0';
+    }
+  }
+  fclose(map);
+  if (!in_map) {
+    fprintf(stderr, "'%s' isn't a map file of GNU ld\n", path);
+  }
+  return in_map;
+}
+
+static unsigned long footprint_flash(const unsigned long * size) {
+  return size[FOOTPRINT_TEXT] + size[FOOTPRINT_RODATA] + size[FOOTPRINT_DATA];
+}
+
+static unsigned long footprint_ram(const unsigned long * size) {
+  return size[FOOTPRINT_DATA] + size[FOOTPRINT_BSS];
+}
+
+static int footprint_compare_groups(const void * a, const void * b) {
+  const footprint_group_t * group_a = a;
+  const footprint_group_t * group_b = b;
+  unsigned long total_a = footprint_flash(group_a->size) + footprint_ram(group_a->size);
+  unsigned long total_b = footprint_flash(group_b->size) + footprint_ram(group_b->size);
+  return total_a < total_b ? 1 : (total_a > total_b ? -1 : strcmp(group_a->name, group_b->name));
+}
+
+static void footprint_print_row(const char * name, const unsigned long * size) {
+  printf("%-40s %8lu %8lu %8lu %8lu %9lu %8lu\n", name, size[FOOTPRINT_TEXT], size[FOOTPRINT_RODATA],
+         size[FOOTPRINT_DATA], size[FOOTPRINT_BSS], footprint_flash(size), footprint_ram(size));
+}
+
+static void footprint_print(const char * title, footprint_table_t * table, int top) {
+  qsort(table->groups, table->count, sizeof(footprint_group_t), footprint_compare_groups);
+  printf("\n%-40s %8s %8s %8s %8s %9s %8s\n", title, "text", "rodata", "data", "bss", "flash", "ram");
+  unsigned long rest[FOOTPRINT_KIND_COUNT] = {0};
+  int rest_count = 0;
+  for (int i = 0; i < table->count; i++) {
+    if (top > 0 && i >= top) {
+      for (int kind = 0; kind < FOOTPRINT_KIND_COUNT; kind++) {
+        rest[kind] += table->groups[i].size[kind];
+      }
+      rest_count++;
+      continue;
+    }
+    footprint_print_row(table->groups[i].name, table->groups[i].size);
+  }
+  if (rest_count > 0) {
+    char name[FOOTPRINT_NAME_SIZE];
+    snprintf(name, sizeof(name), "(%i more)", rest_count);
+    footprint_print_row(name, rest);
+  }
+}
+
+int main(int argc, char ** argv) {
+  const char * path = NULL;
+  int top = 20;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--top") == 0 && i + 1 < argc) {
+      top = atoi(argv[++i]);
+    } else if (path == NULL) {
+      path = argv[i];
+    } else {
+      path = NULL;
+      break;
+    }
+  }
+  if (path == NULL) {
+    fprintf(stderr, "Usage: %s [--top N] tiny-c-compiler.map\n", argv[0]);
+    return 2;
+  }
+  if (!footprint_parse(path)) {
+    return 1;
+  }
+
+  footprint_print("Object", &s_objects, top);
+  if (s_features.count > 0) {
+    footprint_print("libtcc part", &s_features, 0);
+  } else {
+    printf("\nNo input section from libtcc in the map\n");
+  }
+  printf("\n");
+  footprint_print_row("Total", s_total);
+  return 0;
+}
@@ -0,0 +1,160 @@
+//
+// Host side of the app pipeline (see host_compile.h)
+//
+#include "host_compile.h"
+#include "tcc_stubs.h"
+#include "jit_exports.h"
+#include "oom.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static host_result_t * s_current_result = NULL;
+
+typedef struct {
+  const char * source;
+  host_result_t * result;
+  TCCState * state; // Set once tcc_new() succeeded
+} host_job_t;
+
+double host_now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec * 1e-6;
+}
+
+static void host_error_func(void * opaque, const char * msg) {
+  (void)opaque;
+  if (s_current_result != NULL && s_current_result->error[0] == '\0') {
+    snprintf(s_current_result->error, sizeof(s_current_result->error), "%s", msg);
+  }
+}
+
+char * host_read_file(const char * path) {
+  FILE * f = fopen(path, "rb");
+  if (f == NULL) {
+    return NULL;
+  }
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  char * content = size >= 0 ? malloc(size + 1) : NULL;
+  if (content != NULL) {
+    if (fread(content, 1, size, f) != (size_t)size) {
+      free(content);
+      content = NULL;
+    } else {
+      content[size] = '\0';
+    }
+  }
+  fclose(f);
+  return content;
+}
+
+static void host_parse_expected(const char * source, host_result_t * result) {
+  const char * tag = strstr(source, "// expect:");
+  result->has_expected = tag != NULL && sscanf(tag, "// expect: %d", &result->expected) == 1;
+}
+
+// Compile and relocate, run by oom_run(): same steps and same retry as main()
+static int host_compile(void * context, int attempt) {
+  host_job_t * job = context;
+  host_result_t * result = job->result;
+
+  job->state = NULL;
+  double start = host_now_ms();
+  oom_phase("new", false);
+  TCCState * tcc_state = tcc_new();
+  if (!tcc_state) {
+    result->status = "compile";
+    snprintf(result->error, sizeof(result->error), "tcc_new() failed");
+    return -1;
+  }
+  job->state = tcc_state;
+#ifdef HOST_TCC_LIB_PATH
+  tcc_set_lib_path(tcc_state, HOST_TCC_LIB_PATH);
+#endif
+  tcc_set_error_func(tcc_state, NULL, host_error_func);
+  tcc_set_output_type(tcc_state, TCC_OUTPUT_MEMORY);
+  // Same as main(): nothing happens unless a bundle is in use
+  oom_phase("compile", true);
+  int compiled = jit_add_bundle(tcc_state, attempt == 0);
+  if (compiled != -1) {
+    compiled = tcc_compile_string(tcc_state, job->source);
+  }
+  result->compile_ms = host_now_ms() - start;
+  if (compiled == -1) {
+    result->status = "compile";
+    goto failed;
+  }
+
+  oom_phase("symbols", false);
+  jit_add_symbols(tcc_state);
+
+  oom_phase("relocate", false);
+  size_t used_before_relocate = tcc_numworks_heap_used();
+  start = host_now_ms();
+  int relocated = tcc_relocate(tcc_state);
+  result->relocate_ms = host_now_ms() - start;
+  result->image_size = tcc_numworks_heap_used() - used_before_relocate;
+  if (relocated < 0) {
+    result->status = "relocate";
+    goto failed;
+  }
+  return 0;
+
+failed:
+  tcc_delete(tcc_state);
+  job->state = NULL;
+  return -1;
+}
+
+bool host_compile_and_run(const char * source, int arg, host_result_t * result) {
+  memset(result, 0, sizeof(*result));
+  host_parse_expected(source, result);
+  s_current_result = result;
+
+  // Same order as main(): the state itself must live in the TCC heap
+  tcc_numworks_heap_init();
+  tcc_set_realloc(numworks_tcc_realloc);
+
+  host_job_t job = {source, result, NULL};
+  int compiled = oom_run(host_compile, &job, &result->oom);
+  TCCState * tcc_state = job.state;
+  if (result->oom.out_of_memory) {
+    // The state is gone with the TCC heap
+    result->status = "oom";
+    snprintf(result->error, sizeof(result->error), "out of memory in '%s' (%zuB needed, %zuB free)",
+             result->oom.phase, result->oom.demand, result->oom.heap_size);
+    result->heap_peak = result->oom.heap_peak;
+    s_current_result = NULL;
+    return false;
+  }
+  if (compiled != 0) {
+    goto done;
+  }
+
+  runner_main_t entry = (runner_main_t)tcc_get_symbol(tcc_state, "main");
+  if (!entry) {
+    result->status = "no-main";
+    goto done;
+  }
+
+  result->ret = runner_run(entry, arg, &result->run);
+  if (result->run.budget_exceeded) {
+    result->status = "budget";
+  } else if (result->has_expected && result->ret != result->expected) {
+    result->status = "wrong";
+  } else {
+    result->status = "ok";
+  }
+
+done:
+  result->heap_peak = tcc_numworks_heap_peak();
+  if (tcc_state != NULL) {
+    tcc_delete(tcc_state);
+  }
+  s_current_result = NULL;
+  return strcmp(result->status, "ok") == 0;
+}
@@ -0,0 +1,40 @@
+//
+// Host side of the app pipeline: compile a C program with libtcc in the TCC
+// heap of tcc_stubs.c, relocate it, and run its main(arg) with runner.c, while
+// measuring each step. Shared by the host benchmark and batch drivers.
+//
+#ifndef HOST_COMPILE_H
+#define HOST_COMPILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "runner.h"
+#include "oom.h"
+
+typedef struct {
+  // "ok", or the step that failed: "compile", "relocate", "no-main",
+  // "budget" (stopped by the runner), "wrong" (not the expected result),
+  // "oom" (the TCC heap was full, even after a retry)
+  const char * status;
+  double compile_ms;  // tcc_new() and tcc_compile_string()
+  double relocate_ms; // tcc_relocate()
+  size_t heap_peak;   // Peak usage of the TCC heap, in bytes
+  size_t image_size;  // Growth of the TCC heap during tcc_relocate(), in bytes
+  int ret;            // Return value of main(arg)
+  bool has_expected;  // The source has a "// expect: N" line...
+  int expected;       // ... and this is N
+  runner_report_t run;
+  oom_report_t oom;   // Out of memory recovery (see oom.h)
+  char error[256];    // First diagnostic printed by TCC, if any
+} host_result_t;
+
+// Compile and run `source`, filling `result`. Returns true if the status is "ok".
+bool host_compile_and_run(const char * source, int arg, host_result_t * result);
+
+// Read a whole file in a NUL-terminated buffer (free it with free()), or NULL
+char * host_read_file(const char * path);
+
+// Current time, in milliseconds, from the monotonic clock
+double host_now_ms(void);
+
+#endif
@@ -0,0 +1,115 @@
+//
+// Pack the files of a folder into a bundle for the external data of the app
+// (see bundle.h), then check the result with the lookup code of the app
+//
+// Each file is named by its path in the folder, like "include/tcclib.h".
+//
+// Usage: mkbundle OUTPUT FOLDER
+//
+#include "bundle_build.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define MKBUNDLE_PATH_SIZE 512
+
+static bundle_source_t * s_files = NULL;
+static uint32_t s_file_count = 0;
+static uint32_t s_file_capacity = 0;
+
+static char * mkbundle_read(const char * path, size_t * length) {
+  FILE * f = fopen(path, "rb");
+  if (f == NULL) {
+    return NULL;
+  }
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  char * content = size >= 0 ? malloc(size + 1) : NULL;
+  if (content != NULL && fread(content, 1, size, f) == (size_t)size) {
+    content[size] = '\0';
+    *length = size;
+  } else {
+    free(content);
+    content = NULL;
+  }
+  fclose(f);
+  return content;
+}
+
+// Fail on paths too long for the buffers, instead of reading another file
+static void mkbundle_check_length(int length, size_t size, const char * path) {
+  if (length < 0 || (size_t)length >= size) {
+    fprintf(stderr, "'%s...': path too long\n", path);
+    exit(1);
+  }
+}
+
+static void mkbundle_collect(const char * root, const char * relative) {
+  char path[MKBUNDLE_PATH_SIZE];
+  mkbundle_check_length(snprintf(path, sizeof(path), "%s/%s", root, relative), sizeof(path), path);
+  DIR * dir = opendir(path);
+  if (dir == NULL) {
+    fprintf(stderr, "Couldn't open '%s'\n", path);
+    exit(1);
+  }
+  struct dirent * entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (entry->d_name[0] == '.') {
+      continue;
+    }
+    char name[MKBUNDLE_PATH_SIZE];
+    mkbundle_check_length(snprintf(name, sizeof(name), "%s%s%s", relative, relative[0] ? "/" : "", entry->d_name),
+                          sizeof(name), name);
+    mkbundle_check_length(snprintf(path, sizeof(path), "%s/%s", root, name), sizeof(path), path);
+    struct stat info;
+    if (stat(path, &info) != 0) {
+      continue;
+    }
+    if (S_ISDIR(info.st_mode)) {
+      mkbundle_collect(root, name);
+      continue;
+    }
+    if (strlen(name) >= BUNDLE_NAME_SIZE) {
+      fprintf(stderr, "'%s': name too long for the bundle\n", name);
+      exit(1);
+    }
+    if (s_file_count == s_file_capacity) {
+      s_file_capacity = s_file_capacity ? 2 * s_file_capacity : 32;
+      s_files = realloc(s_files, s_file_capacity * sizeof(bundle_source_t));
+    }
+    bundle_source_t * file = &s_files[s_file_count++];
+    snprintf(file->name, sizeof(file->name), "%s", name);
+    file->content = mkbundle_read(path, &file->length);
+    if (file->content == NULL) {
+      fprintf(stderr, "Couldn't read '%s'\n", path);
+      exit(1);
+    }
+  }
+  closedir(dir);
+}
+
+int main(int argc, char ** argv) {
+  if (argc != 3) {
+    fprintf(stderr, "Usage: %s OUTPUT FOLDER\n", argv[0]);
+    return 2;
+  }
+  mkbundle_collect(argv[2], "");
+  size_t size = 0;
+  uint8_t * bundle = bundle_build(s_files, s_file_count, &size);
+  if (bundle == NULL) {
+    fprintf(stderr, "Invalid bundle\n");
+    return 1;
+  }
+
+  FILE * output = fopen(argv[1], "wb");
+  if (output == NULL || fwrite(bundle, 1, size, output) != size) {
+    fprintf(stderr, "Couldn't write '%s'\n", argv[1]);
+    return 1;
+  }
+  fclose(output);
+  printf("%s: %u files, %zu bytes\n", argv[1], s_file_count, size);
+  return 0;
+}
@@ -0,0 +1,50 @@
+//
+// Host front-end of the REPL (see repl.h): snippets are read from stdin
+//
+// Usage: repl_host [--budget MS] < snippets.c   (or interactively)
+//
+#include "repl.h"
+#include "runner.h"
+#include "host_compile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static void repl_host_error(void * opaque, const char * msg) {
+  (void)opaque;
+  fprintf(stderr, "%s\n", msg);
+}
+
+int main(int argc, char ** argv) {
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--budget") == 0 && i + 1 < argc) {
+      runner_set_budget_ms((uint32_t)atoi(argv[++i]));
+    }
+  }
+  bool interactive = isatty(STDIN_FILENO);
+  repl_init(repl_host_error, NULL);
+
+  char line[REPL_INPUT_SIZE];
+  int errors = 0;
+  for (;;) {
+    if (interactive) {
+      printf("%s", repl_pending() ? "... " : "> ");
+    }
+    fflush(stdout);
+    if (fgets(line, sizeof(line), stdin) == NULL) {
+      break;
+    }
+    line[strcspn(line, "\n")] = '\0';
+    double start = host_now_ms();
+    repl_status_t status = repl_feed(line);
+    if (status == REPL_ERROR) {
+      errors++;
+    }
+    if (interactive && (status == REPL_OK || status == REPL_ERROR)) {
+      printf("(%.1f ms)\n", host_now_ms() - start);
+    }
+  }
+  fprintf(stderr, "%d snippets, %d errors\n", repl_snippet_count(), errors);
+  return errors == 0 ? 0 : 1;
+}
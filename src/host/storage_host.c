@@ -0,0 +1,71 @@
+//
+// Fake storage for host builds (see storage.h)
+//
+// storage.c works on 32-bit addresses, so the region is mapped below 4 GB. It
+// is also executable, like the RAM holding the storage on the calculator, so
+// that programs can run in place from a record.
+//
+#include "storage.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#ifndef MAP_32BIT
+#define MAP_32BIT 0
+#endif
+
+// Default size of the fake storage, in KB (NWA_HOST_STORAGE_KB to change it)
+#define STORAGE_HOST_DEFAULT_KB 64
+
+// Magic value at the start of a valid storage, as read by extapp_isValid
+#define STORAGE_HOST_MAGIC 0xEE0BDDBAu
+
+static uint8_t * s_storage = NULL;
+static size_t s_storage_size = 0;
+static size_t s_storage_mapped = 0;
+
+void extapp_hostStorageReset(size_t size) {
+  if (size > s_storage_mapped) {
+    if (s_storage != NULL) {
+      munmap(s_storage, s_storage_mapped);
+    }
+    void * region = mmap((void *)0x10000000, size, PROT_READ | PROT_WRITE | PROT_EXEC,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+    if (region == MAP_FAILED || (uintptr_t)region + size > UINT32_MAX) {
+      fprintf(stderr, "storage_host: couldn't map %zu bytes below 4 GB\n", size);
+      abort();
+    }
+    s_storage = region;
+    s_storage_mapped = size;
+  }
+  s_storage_size = size;
+  memset(s_storage, 0, size);
+  const uint32_t magic = STORAGE_HOST_MAGIC;
+  memcpy(s_storage, &magic, sizeof(magic));
+}
+
+static void storage_host_ensure(void) {
+  if (s_storage == NULL) {
+    const char * storage_kb = getenv("NWA_HOST_STORAGE_KB");
+    extapp_hostStorageReset((storage_kb != NULL ? (size_t)atol(storage_kb) : STORAGE_HOST_DEFAULT_KB) * 1024);
+  }
+}
+
+uint32_t extapp_address() {
+  storage_host_ensure();
+  return (uint32_t)(uintptr_t)s_storage;
+}
+
+uint32_t extapp_size() {
+  storage_host_ensure();
+  return (uint32_t)s_storage_size;
+}
+
+uint8_t extapp_calculatorModel() {
+  return 0;
+}
+
+const uint32_t * extapp_userlandAddress() {
+  return NULL;
+}
@@ -0,0 +1,336 @@
+//
+// Host stress test of storage.c: random writes, reads, erases and listings on
+// the fake storage, checked against a model of the records
+//
+// After each operation, the result is compared with the model, and the layout
+// of the storage is checked: the magic value, records packed one after the
+// other with a valid size and a NUL-terminated name, the same records as the
+// model in the same order, and nothing but zeroes after the last one.
+//
+// Each kind of operation reports its throughput (the time spent in storage.c
+// only), and the bytes it moved per operation: the record written, or what an
+// erase slides down and zeroes. Reads and listings return pointers into the
+// storage, so they move nothing and only walk the records.
+//
+// Usage: storage_stress [--ops N] [--seed N] [--storage-kb N] [--no-check]
+//
+#include "storage.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define STRESS_MAX_RECORDS 64
+#define STRESS_NAME_SIZE 16
+#define STRESS_MAX_CONTENT 4096
+#define STRESS_MAGIC 0xEE0BDDBAu
+
+typedef enum {
+  STRESS_WRITE,
+  STRESS_READ,
+  STRESS_ERASE,
+  STRESS_LIST,
+  STRESS_EXISTS,
+  STRESS_OP_COUNT,
+} stress_op_t;
+
+static const char * const s_op_names[STRESS_OP_COUNT] = {"write", "read", "erase", "list", "exists"};
+
+typedef struct {
+  unsigned long count;
+  unsigned long bytes;
+  double seconds;
+} stress_stats_t;
+
+// The records the storage should hold, in order
+typedef struct {
+  char name[STRESS_NAME_SIZE];
+  size_t length;
+  uint32_t seed; // The content is generated from it
+} stress_record_t;
+
+static stress_record_t s_records[STRESS_MAX_RECORDS];
+static int s_record_count = 0;
+static stress_stats_t s_stats[STRESS_OP_COUNT];
+static uint64_t s_random = 0;
+static unsigned long s_op_index = 0;
+static size_t s_storage_size = 0;
+static unsigned long s_refused_writes = 0;
+
+static uint32_t stress_random(void) {
+  // xorshift64*
+  s_random ^= s_random >> 12;
+  s_random ^= s_random << 25;
+  s_random ^= s_random >> 27;
+  return (uint32_t)((s_random * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+static double stress_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void stress_fail(const char * message, const char * name) {
+  fprintf(stderr, "Operation %lu: %s (%s)\n", s_op_index, message, name != NULL ? name : "-");
+  exit(1);
+}
+
+static void stress_content(uint32_t seed, char * content, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    seed = seed * 1103515245u + 12345u;
+    content[i] = (char)(seed >> 16);
+  }
+}
+
+// A few names share each extension, and some have none
+static void stress_random_name(char * name) {
+  static const char * const extensions[] = {"py", "hc", "xip", ""};
+  uint32_t index = stress_random() % 48;
+  const char * extension = extensions[index % 4];
+  snprintf(name, STRESS_NAME_SIZE, "rec%02u%s%s", index, extension[0] ? "." : "", extension);
+}
+
+// Mostly small records, and a few big ones
+static size_t stress_random_length(void) {
+  uint32_t kind = stress_random() % 16;
+  if (kind == 0) {
+    return stress_random() % STRESS_MAX_CONTENT;
+  }
+  return kind < 4 ? 0 : stress_random() % 256;
+}
+
+static int stress_find(const char * name) {
+  for (int i = 0; i < s_record_count; i++) {
+    if (strcmp(s_records[i].name, name) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static size_t stress_record_size(const stress_record_t * record) {
+  return 2 + strlen(record->name) + 1 + record->length;
+}
+
+static size_t stress_used(void) {
+  size_t used = 4;
+  for (int i = 0; i < s_record_count; i++) {
+    used += stress_record_size(&s_records[i]);
+  }
+  return used;
+}
+
+static void stress_check_layout(void) {
+  const char * start = (const char *)(uintptr_t)extapp_address();
+  const char * end = start + s_storage_size;
+  uint32_t magic;
+  memcpy(&magic, start, sizeof(magic));
+  if (magic != STRESS_MAGIC) {
+    stress_fail("bad magic value", NULL);
+  }
+  const char * offset = start + 4;
+  for (int i = 0; i < s_record_count; i++) {
+    uint16_t size;
+    memcpy(&size, offset, sizeof(size));
+    if (size != stress_record_size(&s_records[i]) || offset + size > end) {
+      stress_fail("bad record size", s_records[i].name);
+    }
+    if (memchr(offset + 2, '\0', size - 2) == NULL || strcmp(offset + 2, s_records[i].name) != 0) {
+      stress_fail("record out of order", s_records[i].name);
+    }
+    offset += size;
+  }
+  if ((size_t)(offset - start) != extapp_used() || (const char *)extapp_nextFree() != offset) {
+    stress_fail("bad used size", NULL);
+  }
+  for (const char * c = offset; c < end; c++) {
+    if (*c != 0) {
+      stress_fail("free storage isn't zeroed", NULL);
+    }
+  }
+}
+
+static void stress_check_content(const stress_record_t * record, const char * content, size_t length) {
+  static char expected[STRESS_MAX_CONTENT];
+  stress_content(record->seed, expected, record->length);
+  if (length != record->length || memcmp(content, expected, length) != 0) {
+    stress_fail("wrong content", record->name);
+  }
+}
+
+static void stress_write(void) {
+  stress_record_t record;
+  stress_random_name(record.name);
+  record.length = stress_random_length();
+  record.seed = stress_random();
+  static char content[STRESS_MAX_CONTENT];
+  stress_content(record.seed, content, record.length);
+
+  // A record is rewritten like xip.c does: erased, then appended
+  int index = stress_find(record.name);
+  if (index >= 0) {
+    extapp_fileErase(record.name);
+    memmove(&s_records[index], &s_records[index + 1], (s_record_count - index - 1) * sizeof(stress_record_t));
+    s_record_count--;
+  }
+  // Room for the record, and the zero size that ends the records
+  bool fits = stress_used() + stress_record_size(&record) + 2 <= s_storage_size &&
+              stress_record_size(&record) <= UINT16_MAX;
+
+  double start = stress_now();
+  bool written = extapp_fileWrite(record.name, content, record.length);
+  s_stats[STRESS_WRITE].seconds += stress_now() - start;
+  if (written != fits) {
+    stress_fail(written ? "write past the end of the storage accepted" : "write refused", record.name);
+  }
+  if (!written) {
+    s_refused_writes++;
+  } else {
+    s_records[s_record_count++] = record;
+    s_stats[STRESS_WRITE].bytes += stress_record_size(&record);
+  }
+}
+
+static void stress_read(void) {
+  char name[STRESS_NAME_SIZE];
+  stress_random_name(name);
+  size_t length = 0;
+  double start = stress_now();
+  const char * content = extapp_fileRead(name, &length);
+  s_stats[STRESS_READ].seconds += stress_now() - start;
+  int index = stress_find(name);
+  if ((content != NULL) != (index >= 0)) {
+    stress_fail(content != NULL ? "read a missing record" : "record not found", name);
+  }
+  if (content != NULL) {
+    stress_check_content(&s_records[index], content, length);
+  }
+}
+
+static void stress_erase(void) {
+  char name[STRESS_NAME_SIZE];
+  stress_random_name(name);
+  int index = stress_find(name);
+  size_t moved = 0;
+  if (index >= 0) {
+    // The records after it slide down, and as many bytes as it took are zeroed
+    for (int i = index + 1; i < s_record_count; i++) {
+      moved += stress_record_size(&s_records[i]);
+    }
+    moved += stress_record_size(&s_records[index]);
+  }
+  double start = stress_now();
+  bool erased = extapp_fileErase(name);
+  s_stats[STRESS_ERASE].seconds += stress_now() - start;
+  if (erased != (index >= 0)) {
+    stress_fail(erased ? "erased a missing record" : "record not erased", name);
+  }
+  if (erased) {
+    memmove(&s_records[index], &s_records[index + 1], (s_record_count - index - 1) * sizeof(stress_record_t));
+    s_record_count--;
+    s_stats[STRESS_ERASE].bytes += moved;
+  }
+}
+
+static void stress_list(void) {
+  static const char * const extensions[] = {"py", "hc", "xip"};
+  const char * names[STRESS_MAX_RECORDS + 1];
+  const char * extension = extensions[stress_random() % 3];
+  // Sometimes with less room than there are records
+  int max = stress_random() % 4 == 0 ? (int)(stress_random() % (STRESS_MAX_RECORDS + 1)) : STRESS_MAX_RECORDS + 1;
+  double start = stress_now();
+  int all = extapp_fileList(names, max, NULL);
+  s_stats[STRESS_LIST].seconds += stress_now() - start;
+  int expected = s_record_count < max ? s_record_count : max;
+  if (all != expected) {
+    stress_fail("wrong number of records listed", NULL);
+  }
+  for (int i = 0; i < all; i++) {
+    if (strcmp(names[i], s_records[i].name) != 0) {
+      stress_fail("wrong record listed", s_records[i].name);
+    }
+  }
+
+  start = stress_now();
+  int matching = extapp_fileListWithExtension(names, max, extension);
+  s_stats[STRESS_LIST].seconds += stress_now() - start;
+  int position = 0;
+  for (int i = 0; i < s_record_count && position < max; i++) {
+    const char * dot = strrchr(s_records[i].name, '.');
+    if (dot != NULL && strcmp(dot + 1, extension) == 0) {
+      if (position >= matching || strcmp(names[position], s_records[i].name) != 0) {
+        stress_fail("wrong record listed by extension", s_records[i].name);
+      }
+      position++;
+    }
+  }
+  if (position != matching) {
+    stress_fail("wrong number of records listed by extension", extension);
+  }
+}
+
+static void stress_exists(void) {
+  char name[STRESS_NAME_SIZE];
+  stress_random_name(name);
+  double start = stress_now();
+  bool exists = extapp_fileExists(name);
+  s_stats[STRESS_EXISTS].seconds += stress_now() - start;
+  if (exists != (stress_find(name) >= 0)) {
+    stress_fail(exists ? "missing record exists" : "record doesn't exist", name);
+  }
+}
+
+int main(int argc, char ** argv) {
+  unsigned long ops = 100000;
+  unsigned long seed = 1;
+  // Small enough for the storage to fill up often
+  size_t storage_kb = 8;
+  bool check = true;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--ops") == 0 && i + 1 < argc) {
+      ops = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      seed = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--storage-kb") == 0 && i + 1 < argc) {
+      storage_kb = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--no-check") == 0) {
+      check = false;
+    } else {
+      fprintf(stderr, "Usage: %s [--ops N] [--seed N] [--storage-kb N] [--no-check]\n", argv[0]);
+      return 2;
+    }
+  }
+  s_random = seed * 0x9E3779B97F4A7C15ull + 1;
+  s_storage_size = storage_kb * 1024;
+  extapp_hostStorageReset(s_storage_size);
+
+  for (s_op_index = 0; s_op_index < ops; s_op_index++) {
+    uint32_t pick = stress_random() % 16;
+    stress_op_t op = pick < 5 ? STRESS_WRITE : pick < 9 ? STRESS_READ : pick < 12 ? STRESS_ERASE :
+                     pick < 14 ? STRESS_LIST : STRESS_EXISTS;
+    switch (op) {
+      case STRESS_WRITE: stress_write(); break;
+      case STRESS_READ: stress_read(); break;
+      case STRESS_ERASE: stress_erase(); break;
+      case STRESS_LIST: stress_list(); break;
+      default: stress_exists(); break;
+    }
+    s_stats[op].count++;
+    if (check) {
+      stress_check_layout();
+    }
+  }
+
+  printf("op,count,ops_per_s,bytes_per_op\n");
+  for (int op = 0; op < STRESS_OP_COUNT; op++) {
+    const stress_stats_t * stats = &s_stats[op];
+    printf("%s,%lu,%.0f,%.1f\n", s_op_names[op], stats->count,
+           stats->seconds > 0 ? stats->count / stats->seconds : 0.0,
+           stats->count > 0 ? (double)stats->bytes / stats->count : 0.0);
+  }
+  fprintf(stderr, "%lu operations, seed %lu, %lu writes refused (storage full), %d records using %zu of %zu bytes%s\n",
+          ops, seed, s_refused_writes, s_record_count, stress_used(), s_storage_size,
+          check ? ", layout checked after each one" : "");
+  return 0;
+}
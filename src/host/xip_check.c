@@ -0,0 +1,73 @@
+//
+// Host check of TCC_XIP: each program runs once from the TCC heap and once
+// from the storage record (see xip.h), and must give the same result
+//
+// The fake storage of storage_host.c is executable, like the RAM holding the
+// storage on the calculator, so the relocated image runs from the record.
+//
+// Usage: xip_check program.c...
+//
+#include "host_compile.h"
+#include "xip.h"
+#include "storage.h"
+#include "tcc_stubs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static char s_xip_error[256];
+
+static void xip_check_error_func(void * opaque, const char * msg) {
+  (void)opaque;
+  if (s_xip_error[0] == '\0') {
+    snprintf(s_xip_error, sizeof(s_xip_error), "%s", msg);
+  }
+}
+
+// Returns true if the program gives the same result from the record
+static bool xip_check_program(const char * path) {
+  char * source = host_read_file(path);
+  if (source == NULL) {
+    printf("%s,missing,,,,,\n", path);
+    return false;
+  }
+
+  host_result_t heap_result;
+  host_compile_and_run(source, 42, &heap_result);
+
+  s_xip_error[0] = '\0';
+  xip_report_t xip_report;
+  runner_main_t entry = xip_build(source, true, xip_check_error_func, NULL, &xip_report);
+  bool same = false;
+  if (entry == NULL) {
+    printf("%s,%s,%d,,%zu,,\"%s\"\n", path, xip_report.failed, heap_result.ret, xip_report.image_size,
+           s_xip_error);
+  } else {
+    // The image lies in the record, and the TCC heap is empty for the run
+    runner_report_t run;
+    size_t heap_used = tcc_numworks_heap_used();
+    int ret = runner_run(entry, 42, &run);
+    same = !run.budget_exceeded && ret == heap_result.ret;
+    printf("%s,%s,%d,%d,%zu,%zu,\"%s\"\n", path, same ? "ok" : "different", heap_result.ret, ret,
+           xip_report.image_size, heap_used, heap_result.error);
+    xip_release();
+  }
+  free(source);
+  return same;
+}
+
+int main(int argc, char ** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s program.c...\n", argv[0]);
+    return 2;
+  }
+  extapp_hostStorageReset(256 * 1024);
+
+  int passed = 0;
+  printf("program,status,heap_ret,xip_ret,image_bytes,heap_used_during_run,error\n");
+  for (int i = 1; i < argc; i++) {
+    passed += xip_check_program(argv[i]);
+  }
+  fprintf(stderr, "%d/%d programs give the same result from the record\n", passed, argc - 1);
+  return passed == argc - 1 ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+//
+// Symbols of the app that the programs compiled by TCC can call
+//
+// To use them, the compiled program declares them as extern, for instance:
+//   extern void fb_pixel(int x, int y, unsigned short color);
+//
+#include "jit_exports.h"
+#include "framebuffer.h"
+#include "bundle.h"
+#include <eadk.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// this function is called by the generated code
+int add(int a, int b) {
+    return a + b;
+}
+
+// this function is opened to the generated code
+void eadk_timing_msleep_int(int ms) {
+  return eadk_timing_msleep((uint32_t) ms);
+}
+
+// this string is referenced by the generated code
+const char hello[] = "Hello World (from TCC)!";
+
+typedef struct {
+  const char * name;
+  const void * address;
+} jit_symbol_t;
+
+static const jit_symbol_t s_jit_symbols[] = {
+  {"add", (const void *)add},
+  {"eadk_timing_msleep_int", (const void *)eadk_timing_msleep_int},
+  {"hello", (const void *)hello},
+
+  // Off-screen framebuffer (framebuffer.h)
+  {"fb_width", (const void *)fb_width},
+  {"fb_height", (const void *)fb_height},
+  {"fb_scale", (const void *)fb_scale},
+  {"fb_rgb", (const void *)fb_rgb},
+  {"fb_clear", (const void *)fb_clear},
+  {"fb_pixel", (const void *)fb_pixel},
+  {"fb_get_pixel", (const void *)fb_get_pixel},
+  {"fb_fill_rect", (const void *)fb_fill_rect},
+  {"fb_rect", (const void *)fb_rect},
+  {"fb_hline", (const void *)fb_hline},
+  {"fb_vline", (const void *)fb_vline},
+  {"fb_line", (const void *)fb_line},
+  {"fb_blit", (const void *)fb_blit},
+  {"fb_present", (const void *)fb_present},
+
+  // C library, as declared by bundle/include/tcclib.h: nothing else links
+  // the compiled program with it on the calculator
+  {"calloc", (const void *)calloc},
+  {"malloc", (const void *)malloc},
+  {"free", (const void *)free},
+  {"realloc", (const void *)realloc},
+  {"atoi", (const void *)atoi},
+  {"strtol", (const void *)strtol},
+  {"strtoul", (const void *)strtoul},
+  {"abs", (const void *)abs},
+  {"qsort", (const void *)qsort},
+  {"printf", (const void *)printf},
+  {"sprintf", (const void *)sprintf},
+  {"snprintf", (const void *)snprintf},
+  {"vsnprintf", (const void *)vsnprintf},
+  {"puts", (const void *)puts},
+  {"putchar", (const void *)putchar},
+  {"strcat", (const void *)strcat},
+  {"strchr", (const void *)strchr},
+  {"strrchr", (const void *)strrchr},
+  {"strcpy", (const void *)strcpy},
+  {"strncpy", (const void *)strncpy},
+  {"strcmp", (const void *)strcmp},
+  {"strncmp", (const void *)strncmp},
+  {"strlen", (const void *)strlen},
+  {"memcpy", (const void *)memcpy},
+  {"memmove", (const void *)memmove},
+  {"memset", (const void *)memset},
+  {"memcmp", (const void *)memcmp},
+  {"sqrt", (const void *)sqrt},
+  {"sin", (const void *)sin},
+  {"cos", (const void *)cos},
+  {"fabs", (const void *)fabs},
+  {"floor", (const void *)floor},
+  {"pow", (const void *)pow},
+};
+
+int jit_add_symbols(TCCState * tcc_state) {
+  int failures = 0;
+  for (size_t i = 0; i < sizeof(s_jit_symbols) / sizeof(s_jit_symbols[0]); i++) {
+    if (tcc_add_symbol(tcc_state, s_jit_symbols[i].name, s_jit_symbols[i].address) < 0) {
+      failures++;
+    }
+  }
+  return failures;
+}
+
+int jit_add_bundle(TCCState * tcc_state, bool helpers) {
+  if (!bundle_ready()) {
+    return 0;
+  }
+  tcc_add_sysinclude_path(tcc_state, BUNDLE_INCLUDE_PATH);
+  // Compiled straight from the bundle, without a copy
+  const char * source = helpers ? bundle_find(BUNDLE_HELPERS, NULL) : NULL;
+  return source != NULL ? tcc_compile_string(tcc_state, source) : 0;
+}
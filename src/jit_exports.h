@@ -0,0 +1,20 @@
+//
+// Symbols of the app that the programs compiled by TCC can call
+//
+#ifndef JIT_EXPORTS_H
+#define JIT_EXPORTS_H
+
+#include <stdbool.h>
+#include "libtcc.h" // for TCCState
+
+// Register all exported symbols in the TCC state. Must be called after
+// tcc_compile_string() and before tcc_relocate(). Returns the number of
+// symbols that couldn't be added.
+int jit_add_symbols(TCCState * tcc_state);
+
+// Give the include path of the bundle (see bundle.h) to a new TCC state, and
+// compile its helper library in it if `helpers` is set. Does nothing without
+// a bundle. Returns -1 if the helper library didn't compile.
+int jit_add_bundle(TCCState * tcc_state, bool helpers);
+
+#endif
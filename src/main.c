@@ -6,6 +6,15 @@
 #include <eadk.h>
 #include "crt_stubs.h"
 #include "tcc_stubs.h"
+#include "framebuffer.h"
+#include "jit_exports.h"
+#include "runner.h"
+#include "mem_pool.h"
+#include "xip.h"
+#include "repl.h"
+#include "repl_keyboard.h"
+#include "bundle.h"
+#include "oom.h"
 
 // See :
 // https://community.arm.com/arm-community-blogs/b/tools-software-ides-blog/posts/using-cmsis-with-arm-compiler-6-without-an-ide
@@ -52,19 +61,7 @@ void *wrapper_around_realloc(void *ptr, size_t size) {
 
 // TODO: write a wrapper file/lib so that the C code interpreted on the NumWorks has correct access to the EADK lib!
 // #include "eadk_lib.h"
-
-// this function is called by the generated code
-int add(int a, int b) {
-    return a + b;
-}
-
-// this function is opened to the generated code
-void eadk_timing_msleep_int(int ms) {
-  return eadk_timing_msleep((uint32_t) ms);
-}
-
-// this string is referenced by the generated code
-const char hello[] = "Hello World (from TCC)!";
+// The functions opened to the generated code are in jit_exports.c
 
 // this long string is the default program to be run if nothing is read from 'tcc.py'
 char long_test_program[] =
@@ -102,37 +99,13 @@ char default_program[] = "int main(int n) { return 0; }";
 const char eadk_app_name[] __attribute__((section(".rodata.eadk_app_name"))) = "Tiny C Compiler";
 const uint32_t eadk_api_level  __attribute__((section(".rodata.eadk_api_level"))) = 0;
 
-// TODO: Check why __exidx_start/__exidx_end is needed
-void __exidx_start() { }
-void __exidx_end() { }
-
-
-// int main() {
-int main(int argc, char ** argv) {
-
-  printf("Tiny C Compiler v0.0.4\n");
-  eadk_timing_msleep(2000);
-
-  printf("Reading from 'tcc.py' file...\n");
-  eadk_timing_msleep(2000);
-
-  // We read "tcc.py"
-  size_t file_len = 0;
-  const char * code_from_file = extapp_fileRead("tcc.py", &file_len);
-
-  if (code_from_file == NULL && file_len <= 0) {
-    printf("Couldn't read 'tcc.py' !\n");
-    eadk_timing_msleep(2000);
-  }
-
-  // DONE: I wasn't able to compile while depending on external data, but it works if reading from a local 'tcc.py' file.
-  // const char * code = eadk_external_data;
-
-  const char * code = (code_from_file == NULL && file_len <= 0) ? "int main(int n) {\nreturn 42;\n}" : (code_from_file + 1);
-
-  // From https://github.com/Tiny-C-Compiler/tinycc-mirror-repository/blob/mob/tests/libtcc_test.c
-  int (*func_main_our_code)(int);
+// The TCC state of the program, once compile_program() succeeded
+static TCCState *s_tcc_state = NULL;
 
+// Compile and relocate the program in `source`, run by oom_run(): a retry after
+// running out of memory goes without the helper library of the bundle
+static int compile_program(void *source, int attempt) {
+  oom_phase("new", false);
   printf("Creating TCC state...\n");
   eadk_timing_msleep(2000);
 
@@ -144,16 +117,6 @@ int main(int argc, char ** argv) {
     eadk_timing_msleep(2000);
     return 1;
   }
-
-  // Initialize your TCC heap (reset the bump allocator)
-  printf("Initialize our TCC heap...\n");
-  eadk_timing_msleep(2000);
-  tcc_numworks_heap_init();
-
-  // Set custom memory allocators, from our tcc_stubs implementation:
-  printf("tcc_set_realloc(numworks_tcc_realloc)\n");
-  eadk_timing_msleep(2000);
-  tcc_set_realloc(numworks_tcc_realloc);
   // tcc_set_realloc(numworks_tcc_malloc, numworks_tcc_realloc, numworks_tcc_free);
 
   // // Use stdlib's memory allocators:
@@ -175,33 +138,34 @@ int main(int argc, char ** argv) {
   eadk_timing_msleep(2000);
   tcc_set_output_type(tcc_state, TCC_OUTPUT_MEMORY);
 
-  // TODO: first test a tiny C code, then more!
-  const char * code_to_execute = default_program;
-  // TODO: then test a longer C code, then more!
-  // const char * code_to_execute = long_test_program;
-  // TODO: then from the local storage
-  // const char * code_to_execute = code;
+  // #include <tcclib.h> and <numworks.h> come from the bundle, with its helper library
+  oom_phase("compile", true);
+  if (jit_add_bundle(tcc_state, attempt == 0) == -1) {
+    printf("WARN: the helper library didn't compile\n");
+    eadk_timing_msleep(2000);
+  }
 
   printf("tcc_compile_string(...)\n");
   eadk_timing_msleep(2000);
 
-  if (tcc_compile_string(tcc_state, code_to_execute) == -1) {
+  if (tcc_compile_string(tcc_state, source) == -1) {
     printf("ERR: couldn't compile\n");
     eadk_timing_msleep(2000);
     tcc_delete(tcc_state); // delete the state
     return 1;
   }
 
-  // FIXME: try this!
-  // // as a test, we add symbols that the compiled program can use.
-  // // You may also open a dll with tcc_add_dll() and use symbols from that
-  // printf("3 tcc_add_symbol(...)\n");
-  // eadk_timing_msleep(2000);
-  // tcc_add_symbol(tcc_state, "add", add);
-  // tcc_add_symbol(tcc_state, "eadk_timing_msleep_int", eadk_timing_msleep_int);
-  // tcc_add_symbol(tcc_state, "hello", hello);
+  // We add the symbols that the compiled program can use (see jit_exports.c)
+  oom_phase("symbols", false);
+  printf("jit_add_symbols(tcc_state)\n");
+  eadk_timing_msleep(2000);
+  if (jit_add_symbols(tcc_state) > 0) {
+    printf("WARN: some symbols couldn't be added\n");
+    eadk_timing_msleep(2000);
+  }
 
   // Relocate the code (prepare for execution)
+  oom_phase("relocate", false);
   printf("tcc_relocate(tcc_state)\n");
   eadk_timing_msleep(2000);
   if (tcc_relocate(tcc_state) < 0) {
@@ -211,6 +175,145 @@ int main(int argc, char ** argv) {
     return 1;
   }
 
+  s_tcc_state = tcc_state;
+  return 0;
+}
+
+#if TCC_XIP
+// The main() of the program built by build_program_xip(), and its report
+static runner_main_t s_xip_main = NULL;
+static xip_report_t s_xip_report;
+
+// Compile with the image in a storage record (see xip.h), run by oom_run(): a
+// retry after running out of memory goes without the helper library too
+static int build_program_xip(void *source, int attempt) {
+  s_xip_main = xip_build(source, attempt == 0, handle_error, stderr, &s_xip_report);
+  return s_xip_main != NULL ? 0 : 1;
+}
+#endif
+
+// TODO: Check why __exidx_start/__exidx_end is needed
+void __exidx_start() { }
+void __exidx_end() { }
+
+
+// int main() {
+int main(int argc, char ** argv) {
+  // The pool of free RAM ends below the stack of main(), so it comes first,
+  // before printf() allocates from it (see mem_pool.h)
+  mem_pool_init();
+
+  printf("Tiny C Compiler v0.0.4\n");
+  eadk_timing_msleep(2000);
+
+  printf("Reading from 'tcc.py' file...\n");
+  eadk_timing_msleep(2000);
+
+  // We read "tcc.py"
+  size_t file_len = 0;
+  const char * code_from_file = extapp_fileRead("tcc.py", &file_len);
+
+  if (code_from_file == NULL && file_len <= 0) {
+    printf("Couldn't read 'tcc.py' !\n");
+    eadk_timing_msleep(2000);
+  }
+
+  // Headers, helper library and examples installed as external data (see bundle.h)
+  if (bundle_init(get_eadk_data())) {
+    printf("Bundle: %d files\n", bundle_count());
+  } else {
+    printf("WARN: no bundle in external data\n");
+  }
+  eadk_timing_msleep(2000);
+
+  // DONE: I wasn't able to compile while depending on external data, but it works if reading from a local 'tcc.py' file.
+  // const char * code = eadk_external_data;
+
+  const char * code = (code_from_file == NULL && file_len <= 0) ? "int main(int n) {\nreturn 42;\n}" : (code_from_file + 1);
+
+  // TODO: first test a tiny C code, then more!
+  const char * code_to_execute = default_program;
+  // TODO: then test a longer C code, then more!
+  // const char * code_to_execute = long_test_program;
+  // TODO: then from the local storage
+  // const char * code_to_execute = code;
+
+  // From https://github.com/Tiny-C-Compiler/tinycc-mirror-repository/blob/mob/tests/libtcc_test.c
+  int (*func_main_our_code)(int);
+
+  // Initialize our TCC heap: blocks taken from the top of the pool, that TCC
+  // frees and the heap reclaims when it runs out (see tcc_stubs.c)
+  // This must come before tcc_new(), so that the state itself lives in our heap
+  printf("Initialize our TCC heap...\n");
+  eadk_timing_msleep(2000);
+  tcc_numworks_heap_init();
+  printf("Free RAM: %zuKB (model %d)\n", tcc_numworks_heap_size() / 1024, mem_pool_model());
+  eadk_timing_msleep(2000);
+
+#if TCC_REPL
+  // Interactive mode: one snippet per line, until the Back key (see repl.h)
+  if (!fb_init_from_pool()) {
+    printf("WARN: no RAM for the framebuffer\n");
+    eadk_timing_msleep(2000);
+  }
+  printf("Runner: %s\n", runner_mode());
+  repl_init(handle_error, stderr);
+  char repl_line[REPL_INPUT_SIZE];
+  while (repl_keyboard_read_line(repl_pending() ? "... " : "> ", repl_line, sizeof(repl_line))) {
+    repl_feed(repl_line);
+  }
+  repl_reset();
+  printf("End of TCC main()\n");
+  eadk_timing_msleep(2000);
+  return 0;
+#endif
+
+  // Set custom memory allocators, from our tcc_stubs implementation:
+  printf("tcc_set_realloc(numworks_tcc_realloc)\n");
+  eadk_timing_msleep(2000);
+  tcc_set_realloc(numworks_tcc_realloc);
+
+#if TCC_XIP
+  // Compile with the image in a storage record, and free the whole TCC heap,
+  // once more with less if TCC ran out of memory (see xip.h and oom.h)
+  printf("xip_build(...)\n");
+  eadk_timing_msleep(2000);
+  oom_report_t oom_report;
+  if (oom_run(build_program_xip, (void *)code_to_execute, &oom_report) != 0) {
+    if (oom_report.out_of_memory) {
+      printf("ERR: out of memory in '%s' (%zuB needed, %zuB free)\n",
+             oom_report.phase, oom_report.demand, oom_report.heap_size);
+    } else {
+      printf("ERR: XIP build failed (%s)\n", s_xip_report.failed);
+    }
+    eadk_timing_msleep(2000);
+    xip_release();
+    return 1;
+  }
+  if (oom_report.attempts > 1) {
+    printf("WARN: compiled without the helper library (out of memory)\n");
+    eadk_timing_msleep(2000);
+  }
+  func_main_our_code = s_xip_main;
+  printf("XIP: image %zuB in '%s'\n", s_xip_report.image_size, XIP_RECORD_NAME);
+  eadk_timing_msleep(2000);
+#else
+  // Compile and relocate, and once more with less if TCC ran out of memory (see oom.h)
+  oom_report_t oom_report;
+  if (oom_run(compile_program, (void *)code_to_execute, &oom_report) != 0) {
+    if (oom_report.out_of_memory) {
+      printf("ERR: out of memory in '%s' (%zuB needed, %zuB free)\n",
+             oom_report.phase, oom_report.demand, oom_report.heap_size);
+      eadk_timing_msleep(2000);
+    }
+    return 1;
+  }
+  if (oom_report.attempts > 1) {
+    printf("WARN: compiled without the helper library (out of memory)\n");
+    eadk_timing_msleep(2000);
+  }
+  TCCState *tcc_state = s_tcc_state;
+
   // get entry symbol
   func_main_our_code = tcc_get_symbol(tcc_state, "main");
   if (!func_main_our_code) {
@@ -219,6 +322,7 @@ int main(int argc, char ** argv) {
     tcc_delete(tcc_state); // delete the state
     return 1;
   }
+#endif
 
   // See https://github.com/numworks/epsilon/blob/9072ab80a16d4c15222699f73896282a65eecd54/python/src/py/emitglue.c#L119 for an internal usage of this code, in the micropython app for epsilon OS
   // !!! IMPORTANT: Instruction Cache Invalidation !!!
@@ -239,22 +343,57 @@ int main(int argc, char ** argv) {
   // Finding start_addr and size: TCC doesn't easily expose this, often
   // you'd invalidate the entire heap where code could be.
 
-  printf("Launching main(42)...\n");
+  // The compiled program may draw in the off-screen framebuffer, taken from
+  // the RAM left after compiling: full resolution if there's enough of it
+  if (!fb_init_from_pool()) {
+    printf("WARN: no RAM for the framebuffer\n");
+    eadk_timing_msleep(2000);
+  } else {
+    printf("Framebuffer: %dx%d\n", fb_width(), fb_height());
+  }
+
+  printf("Launching main(42) (%s)...\n", runner_mode());
   eadk_timing_msleep(2000);
 
-  // run the compiled code, print the return value (for debugging)
-  int ret_val = func_main_our_code(42);
+  // run the compiled code on its own stack, print the return value (for debugging)
+  runner_report_t run_report;
+  int ret_val = runner_run(func_main_our_code, 42, &run_report);
   // int ret_val = tcc_run(tcc_state, argc, argv);
 
+  if (run_report.budget_exceeded) {
+    printf("ERR: stopped after %lums (budget)\n", (unsigned long)runner_budget_ms());
+    eadk_timing_msleep(2000);
+  }
+
   printf("Return: %d\n", ret_val);
   eadk_timing_msleep(2000);
   printf("Return: %d\n", ret_val);
   eadk_timing_msleep(2000);
 
+  // Cycles (in thousands, to fit in 32 bits) and wall time of the run
+  printf("Time: %lu kcycles, %lu ms\n",
+         (unsigned long)(run_report.cycles / 1000), (unsigned long)(run_report.wall_us / 1000));
+  eadk_timing_msleep(2000);
+
+  // Peak stack usage, to tune RUNNER_STACK_SIZE
+  printf("Stack: peak %zuB / %zuB\n", run_report.stack_peak, run_report.stack_size);
+  eadk_timing_msleep(2000);
+  if (run_report.stack_overflow) {
+    printf("ERR: stack overflow (guard overwritten)\n");
+    eadk_timing_msleep(2000);
+  }
+
+#if TCC_XIP
+  // The TCC state is already gone, only the record is left
+  printf("xip_release()...\n");
+  eadk_timing_msleep(2000);
+  xip_release();
+#else
   // Clean up TCC state
   printf("tcc_delete(tcc_state)...\n");
   eadk_timing_msleep(2000);
   tcc_delete(tcc_state); // delete the state
+#endif
 
   // printf("End of interpretation of 'tcc.py'...\n");
   printf("End of TCC main()\n");
@@ -0,0 +1,148 @@
+//
+// Single pool for all the free RAM of the app (see mem_pool.h)
+//
+#include "mem_pool.h"
+#include "storage.h"
+#include <errno.h>
+
+#include <stdio.h>
+
+#ifdef NUMWORKS_HOST
+#include <stdlib.h>
+#else
+#include <eadk.h> // For eadk_timing_msleep
+#endif
+
+static uintptr_t s_pool_start = 0; // Aligned end of .bss
+static uintptr_t s_pool_end = 0;   // Aligned stack limit
+static uintptr_t s_pool_break = 0; // End of the newlib heap (low end)
+static uintptr_t s_pool_top = 0;   // Start of the TCC heap (high end)
+static uint8_t s_pool_model = 0;
+static bool s_pool_ready = false;
+
+static uintptr_t mem_pool_align_up(uintptr_t value) {
+  return (value + MEM_POOL_ALIGN - 1) & ~(uintptr_t)(MEM_POOL_ALIGN - 1);
+}
+
+static uintptr_t mem_pool_align_down(uintptr_t value) {
+  return value & ~(uintptr_t)(MEM_POOL_ALIGN - 1);
+}
+
+void mem_pool_init_region(void * base, size_t size) {
+  s_pool_start = mem_pool_align_up((uintptr_t)base);
+  s_pool_end = mem_pool_align_down((uintptr_t)base + size);
+  if (s_pool_end < s_pool_start) {
+    s_pool_end = s_pool_start;
+  }
+  s_pool_break = s_pool_start;
+  s_pool_top = s_pool_end;
+  s_pool_ready = true;
+}
+
+#ifdef NUMWORKS_HOST
+
+void mem_pool_init(void) {
+  const char * ram_kb = getenv("NWA_HOST_RAM_KB");
+  size_t size = (ram_kb != NULL ? (size_t)atol(ram_kb) : MEM_POOL_HOST_DEFAULT_KB) * 1024;
+  // Never freed: like the RAM of the calculator, it lasts as long as the app
+  void * region = malloc(size);
+  if (region == NULL) {
+    fprintf(stderr, "mem_pool: couldn't allocate %zu bytes\n", size);
+    size = 0;
+  }
+  mem_pool_init_region(region, size);
+}
+
+#else
+
+extern char end; // End of .bss, from the linker
+
+void mem_pool_init(void) {
+  s_pool_model = extapp_calculatorModel();
+
+  // The stack grows down towards .bss: the address of a local is close enough
+  // to the stack pointer, the reserve keeps room for the deepest app calls.
+  // The stack is in RAM on every model, so it bounds the pool without any
+  // per-model RAM address.
+  char marker;
+  uintptr_t stack = (uintptr_t)&marker;
+  uintptr_t start = (uintptr_t)&end;
+
+  if (stack > start + MEM_POOL_STACK_RESERVE) {
+    mem_pool_init_region(&end, stack - MEM_POOL_STACK_RESERVE - start);
+  } else {
+    // Nothing past .bss is known to be free: better no pool than one over the stack
+    mem_pool_init_region(&end, 0);
+    printf("ERR: no free RAM above .bss\n");
+    eadk_timing_msleep(2000);
+  }
+}
+
+#endif
+
+static void mem_pool_ensure(void) {
+  if (!s_pool_ready) {
+    mem_pool_init();
+  }
+}
+
+size_t mem_pool_size(void) {
+  mem_pool_ensure();
+  return s_pool_end - s_pool_start;
+}
+
+size_t mem_pool_free(void) {
+  mem_pool_ensure();
+  return s_pool_top - s_pool_break;
+}
+
+uint8_t mem_pool_model(void) {
+  mem_pool_ensure();
+  return s_pool_model;
+}
+
+void * mem_pool_sbrk(ptrdiff_t increment) {
+  mem_pool_ensure();
+  uintptr_t previous = s_pool_break;
+  if ((increment > 0 && (size_t)increment > s_pool_top - s_pool_break) ||
+      (increment < 0 && (size_t)-increment > s_pool_break - s_pool_start)) {
+    errno = ENOMEM;
+    return (void *)-1;
+  }
+  s_pool_break += increment;
+  return (void *)previous;
+}
+
+void * mem_pool_top_alloc(size_t size) {
+  mem_pool_ensure();
+  size_t aligned_size = mem_pool_align_up(size);
+  if (aligned_size < size || aligned_size > s_pool_top - s_pool_break) {
+    return NULL;
+  }
+  s_pool_top -= aligned_size;
+  return (void *)s_pool_top;
+}
+
+void mem_pool_top_release(size_t size) {
+  size_t aligned_size = mem_pool_align_up(size);
+  s_pool_top = aligned_size < s_pool_end - s_pool_top ? s_pool_top + aligned_size : s_pool_end;
+}
+
+void mem_pool_top_reset(void) {
+  mem_pool_ensure();
+  s_pool_top = s_pool_end;
+}
+
+void * mem_pool_top_start(void) {
+  mem_pool_ensure();
+  return (void *)s_pool_top;
+}
+
+size_t mem_pool_top_used(void) {
+  mem_pool_ensure();
+  return s_pool_end - s_pool_top;
+}
+
+bool mem_pool_top_contains(const void * ptr) {
+  return (uintptr_t)ptr >= s_pool_top && (uintptr_t)ptr < s_pool_end;
+}
@@ -0,0 +1,72 @@
+//
+// Single pool for all the free RAM of the app
+//
+// At startup, the pool takes the free region between the end of .bss and the
+// stack limit, so each calculator model gets all of its RAM. It is shared from
+// both ends:
+//
+//   end of .bss                                               stack limit
+//   | newlib heap (_sbrk) -->                   <-- TCC heap |
+//
+// so newlib and TCC can use whatever the other one doesn't need.
+//
+#ifndef MEM_POOL_H
+#define MEM_POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Stack left to the app below the stack pointer seen at startup
+#ifndef MEM_POOL_STACK_RESERVE
+#define MEM_POOL_STACK_RESERVE (16 * 1024)
+#endif
+
+// On the host, the size of the simulated RAM region, in KB, can be set with
+// the NWA_HOST_RAM_KB environment variable
+#define MEM_POOL_HOST_DEFAULT_KB (4 * 1024)
+
+// Both ends are kept aligned on this: 8 bytes on the calculator, 16 on 64-bit hosts
+#define MEM_POOL_ALIGN (2 * sizeof(size_t))
+
+// Discover the free region. If the stack isn't above .bss, the region can't be
+// found and the pool stays empty. On the calculator, the region ends
+// MEM_POOL_STACK_RESERVE below the stack pointer of the caller, so main() must
+// call it first, before anything allocates (printf included): on first use
+// from a deeper frame, the functions below would set that bound themselves,
+// from wherever the stack is at that time. Calling it again empties the pool.
+void mem_pool_init(void);
+// Use [base, base + size) as the pool instead, for the host and tests
+void mem_pool_init_region(void * base, size_t size);
+
+size_t mem_pool_size(void);
+// Free bytes between the two ends
+size_t mem_pool_free(void);
+// Calculator model the region was computed for (see extapp_calculatorModel)
+uint8_t mem_pool_model(void);
+
+// Low end, for newlib: same contract as sbrk(), (void *)-1 when full
+void * mem_pool_sbrk(ptrdiff_t increment);
+
+// High end, for the TCC heap: move the end down by `size` bytes (rounded up to
+// MEM_POOL_ALIGN) and return the new end, or NULL when full
+void * mem_pool_top_alloc(size_t size);
+// Give back the lowest `size` bytes of the high end
+void mem_pool_top_release(size_t size);
+// Give back the whole high end
+void mem_pool_top_reset(void);
+// Current lowest address of the high end, and its size
+void * mem_pool_top_start(void);
+size_t mem_pool_top_used(void);
+// True if ptr lies in the high end
+bool mem_pool_top_contains(const void * ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,101 @@
+//
+// Recovery from a TCC heap that runs out of memory (see oom.h)
+//
+#include "oom.h"
+#include "tcc_stubs.h"
+#include "mem_pool.h"
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef NUMWORKS_HOST
+#include <malloc.h> // For malloc_trim
+#endif
+
+static jmp_buf s_oom_jump;
+static bool s_oom_armed = false;
+static bool s_oom_failed = false;
+static const char * s_oom_phase = NULL;
+static bool s_oom_tcc_unwinds = false;
+static oom_report_t * s_oom_report = NULL;
+
+void oom_phase(const char * phase, bool tcc_unwinds) {
+  s_oom_phase = phase;
+  s_oom_tcc_unwinds = tcc_unwinds;
+}
+
+static bool oom_handler(size_t aligned_size) {
+  if (!s_oom_armed) {
+    return false;
+  }
+  if (!s_oom_failed) {
+    s_oom_failed = true;
+    s_oom_report->phase = s_oom_phase != NULL ? s_oom_phase : "unknown";
+    s_oom_report->request = aligned_size;
+    s_oom_report->demand = tcc_numworks_heap_used() + aligned_size;
+    s_oom_report->heap_size = tcc_numworks_heap_size();
+  }
+  if (s_oom_tcc_unwinds) {
+    // TCC gets NULL and reports the error, with the reserve to do it
+    tcc_numworks_heap_set_reserve(0);
+    return false;
+  }
+  longjmp(s_oom_jump, 1);
+}
+
+// Give back to the pool what can be, before trying again
+static size_t oom_release(void) {
+  size_t free_before = mem_pool_free();
+  // The failed state and its caches (include files, diagnostics...) go with the heap
+  tcc_numworks_heap_init();
+#ifndef NUMWORKS_HOST
+  // Memory freed to newlib stays in its free lists until trimmed
+  malloc_trim(0);
+#endif
+  return mem_pool_free() - free_before;
+}
+
+// Kept apart so that no local of oom_run() is live across the longjmp
+static int oom_attempt(oom_compile_t compile, void * context, int attempt) {
+  if (setjmp(s_oom_jump) != 0) {
+    return -1;
+  }
+  return compile(context, attempt);
+}
+
+int oom_run(oom_compile_t compile, void * context, oom_report_t * report) {
+  memset(report, 0, sizeof(*report));
+  s_oom_report = report;
+  int result = -1;
+  for (int attempt = 0; attempt <= OOM_RETRIES; attempt++) {
+    if (attempt > 0) {
+      report->released += oom_release();
+    }
+    report->attempts++;
+    s_oom_failed = false;
+    oom_phase(NULL, false);
+    tcc_numworks_heap_set_reserve(OOM_RESERVE);
+    tcc_numworks_heap_set_oom_handler(oom_handler);
+    s_oom_armed = true;
+
+    result = oom_attempt(compile, context, attempt);
+    s_oom_armed = false;
+    tcc_numworks_heap_set_oom_handler(NULL);
+    tcc_numworks_heap_set_reserve(0);
+    report->out_of_memory = s_oom_failed;
+    report->reclaimed = tcc_numworks_heap_reclaimed();
+    if (s_oom_failed) {
+      report->heap_peak = tcc_numworks_heap_peak();
+    } else {
+      break;
+    }
+  }
+  if (report->out_of_memory) {
+    // The state of the last attempt is gone too
+    tcc_numworks_heap_init();
+    result = -1;
+  }
+  oom_phase(NULL, false);
+  s_oom_report = NULL;
+  return result;
+}
@@ -0,0 +1,65 @@
+//
+// Recovery from a TCC heap that runs out of memory during a compilation
+//
+// When an allocation doesn't fit, tcc_stubs.c first reuses the blocks that TCC
+// freed. If that's not enough, the handler of this module unwinds the
+// compilation back to oom_run(), instead of returning NULL into libtcc (which
+// exits the app when it's not compiling). The abandoned TCC state can't be
+// deleted, so the whole TCC heap is reset instead, the free memory of newlib
+// is given back to the pool, and the compilation is tried again.
+//
+// While tcc_compile_string() runs, libtcc unwinds by itself when an allocation
+// fails: it reports "memory full" and returns -1. So in that phase the handler
+// only records the failure, and frees a small reserve for the error path of TCC.
+//
+#ifndef OOM_H
+#define OOM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// Compilations tried again after running out of memory
+#ifndef OOM_RETRIES
+#define OOM_RETRIES 1
+#endif
+
+// Free bytes of the pool kept for the error path of TCC
+#ifndef OOM_RESERVE
+#define OOM_RESERVE 1024
+#endif
+
+typedef struct {
+  bool out_of_memory; // The last attempt ran out of memory
+  int attempts;       // Number of compilations tried
+  const char * phase; // Phase of the first failed allocation (see oom_phase)
+  size_t request;     // Size of that allocation, in bytes
+  size_t demand;      // TCC heap usage it asked for: usage at that time + request
+  size_t heap_peak;   // Peak usage of the TCC heap during the failed attempt
+  size_t heap_size;   // What the TCC heap could get at that time
+  size_t reclaimed;   // Bytes reused from blocks freed by TCC, last attempt
+  size_t released;    // Bytes given back to the pool before retrying
+} oom_report_t;
+
+// Compile (and relocate) a program: returns 0 on success. `attempt` is 0 the
+// first time, and more on retries, so that it can try with less (for instance
+// without the helper library).
+typedef int (*oom_compile_t)(void * context, int attempt);
+
+// Run `compile`, and try again if it ran out of memory. Returns its result, or
+// -1 if it was unwound.
+int oom_run(oom_compile_t compile, void * context, oom_report_t * report);
+
+// Name the current phase of the compilation ("new", "compile", "symbols",
+// "relocate"...). `tcc_unwinds` is set while libtcc handles a failed
+// allocation by itself, that is inside tcc_compile_string().
+void oom_phase(const char * phase, bool tcc_unwinds);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,601 @@
+//
+// Interactive mode: compile and run C snippets one at a time (see repl.h)
+//
+#include "repl.h"
+#include "tcc_stubs.h"
+#include "jit_exports.h"
+#include "runner.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef NUMWORKS_HOST
+#define STM32F730xx
+#include "stm32f7xx.h"
+#endif
+
+// States kept alive, one per snippet that defined functions or variables
+#define REPL_MAX_STATES 128
+
+// Name of the function wrapping a statement or an expression
+#define REPL_EVAL_NAME "__repl_eval"
+
+typedef enum {
+  REPL_KIND_DIRECTIVE, // #include, #define...
+  REPL_KIND_TYPE,      // typedef, or struct/union/enum definition
+  REPL_KIND_PROTOTYPE, // Declaration only: function prototype, extern variable
+  REPL_KIND_FUNCTION,  // Function definition
+  REPL_KIND_VARIABLE,  // Global variable definition
+  REPL_KIND_STATEMENT, // Anything else, run right away
+} repl_kind_t;
+
+typedef struct {
+  char name[REPL_NAME_SIZE];
+  const void * address;
+} repl_symbol_t;
+
+// Value printers of expression snippets
+static void repl_print_long(long long value) { printf("%lld\n", value); }
+static void repl_print_ulong(unsigned long long value) { printf("%llu\n", value); }
+static void repl_print_double(double value) { printf("%g\n", value); }
+static void repl_print_string(const char * value) { printf("\"%s\"\n", value); }
+static void repl_print_pointer(const void * value) { printf("%p\n", value); }
+
+static const repl_symbol_t s_repl_printers[] = {
+  {"__repl_print_long", (const void *)repl_print_long},
+  {"__repl_print_ulong", (const void *)repl_print_ulong},
+  {"__repl_print_double", (const void *)repl_print_double},
+  {"__repl_print_string", (const void *)repl_print_string},
+  {"__repl_print_pointer", (const void *)repl_print_pointer},
+};
+
+// Compiled before the prelude of each snippet
+static const char s_repl_header[] =
+  "int printf(const char *, ...);\n"
+  "void __repl_print_long(long long);\n"
+  "void __repl_print_ulong(unsigned long long);\n"
+  "void __repl_print_double(double);\n"
+  "void __repl_print_string(const char *);\n"
+  "void __repl_print_pointer(const void *);\n"
+  "#define __repl_print(e) _Generic((e),"
+  " _Bool: __repl_print_long, char: __repl_print_long, signed char: __repl_print_long,"
+  " short: __repl_print_long, int: __repl_print_long, long: __repl_print_long, long long: __repl_print_long,"
+  " unsigned char: __repl_print_ulong, unsigned short: __repl_print_ulong, unsigned: __repl_print_ulong,"
+  " unsigned long: __repl_print_ulong, unsigned long long: __repl_print_ulong,"
+  " float: __repl_print_double, double: __repl_print_double,"
+  " char *: __repl_print_string, const char *: __repl_print_string,"
+  " default: __repl_print_pointer)(e)\n";
+
+// Words that start a statement, never a declaration
+static const char * const s_repl_statement_words[] = {
+  "if", "for", "while", "do", "switch", "return", "goto", "break", "continue", "else",
+};
+
+// Words that start a declaration (with the typedef names of the session)
+static const char * const s_repl_type_words[] = {
+  "void", "char", "short", "int", "long", "float", "double", "signed", "unsigned",
+  "_Bool", "const", "volatile", "static", "extern", "struct", "union", "enum", "typedef",
+  "inline",
+};
+
+static TCCErrorFunc s_repl_error_func = NULL;
+static void * s_repl_error_opaque = NULL;
+static bool s_repl_quiet = false; // Drop the diagnostics of a first attempt
+
+static char s_repl_input[REPL_INPUT_SIZE];
+static size_t s_repl_input_length = 0;
+static char s_repl_prelude[REPL_PRELUDE_SIZE];
+static size_t s_repl_prelude_length = 0;
+
+static repl_symbol_t s_repl_symbols[REPL_MAX_SYMBOLS];
+static int s_repl_symbol_count = 0;
+static char s_repl_typedefs[REPL_MAX_SYMBOLS][REPL_NAME_SIZE];
+static int s_repl_typedef_count = 0;
+
+static TCCState * s_repl_states[REPL_MAX_STATES];
+static int s_repl_state_count = 0;
+
+static void repl_error_func(void * opaque, const char * msg) {
+  (void)opaque;
+  if (!s_repl_quiet && s_repl_error_func != NULL) {
+    s_repl_error_func(s_repl_error_opaque, msg);
+  }
+}
+
+void repl_init(TCCErrorFunc error_func, void * error_opaque) {
+  s_repl_error_func = error_func;
+  s_repl_error_opaque = error_opaque;
+  s_repl_state_count = 0;
+  repl_reset();
+}
+
+void repl_reset(void) {
+  // In reverse order, so that the TCC heap gives back each last block
+  while (s_repl_state_count > 0) {
+    tcc_delete(s_repl_states[--s_repl_state_count]);
+  }
+  tcc_numworks_heap_init();
+  tcc_set_realloc(numworks_tcc_realloc);
+  s_repl_input_length = 0;
+  s_repl_prelude_length = 0;
+  s_repl_prelude[0] = '\0';
+  s_repl_symbol_count = 0;
+  s_repl_typedef_count = 0;
+}
+
+bool repl_pending(void) {
+  return s_repl_input_length > 0;
+}
+
+int repl_snippet_count(void) {
+  return s_repl_state_count;
+}
+
+//
+// Scanning the snippet
+//
+
+static bool repl_is_identifier_char(char c) {
+  return isalnum((unsigned char)c) || c == '_';
+}
+
+// Length of the identifier at `text`, 0 if there's none
+static size_t repl_identifier_length(const char * text) {
+  size_t length = 0;
+  if (isalpha((unsigned char)text[0]) || text[0] == '_') {
+    while (repl_is_identifier_char(text[length])) {
+      length++;
+    }
+  }
+  return length;
+}
+
+static bool repl_word_is(const char * text, size_t length, const char * word) {
+  return strlen(word) == length && strncmp(text, word, length) == 0;
+}
+
+static bool repl_word_in(const char * text, size_t length, const char * const * words, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    if (repl_word_is(text, length, words[i])) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool repl_is_type_word(const char * text, size_t length) {
+  if (repl_word_in(text, length, s_repl_type_words, sizeof(s_repl_type_words) / sizeof(s_repl_type_words[0]))) {
+    return true;
+  }
+  for (int i = 0; i < s_repl_typedef_count; i++) {
+    if (repl_word_is(text, length, s_repl_typedefs[i])) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Offsets of the first '(', '{', '=' and '[' outside of any bracket, string or
+// comment (or -1), and whether the brackets are balanced
+typedef struct {
+  int paren;
+  int brace;
+  int equal;
+  int bracket;
+  int last_brace_end; // Just after the last top-level '}'
+  bool balanced;
+} repl_scan_t;
+
+static repl_scan_t repl_scan(const char * text) {
+  repl_scan_t scan = {-1, -1, -1, -1, -1, true};
+  int depth = 0;
+  for (int i = 0; text[i] != '\0'; i++) {
+    char c = text[i];
+    if (c == '"' || c == '\'') {
+      for (i++; text[i] != '\0' && text[i] != c; i++) {
+        if (text[i] == '\\' && text[i + 1] != '\0') {
+          i++;
+        }
+      }
+      if (text[i] == '\0') {
+        scan.balanced = false;
+        return scan;
+      }
+    } else if (c == '/' && text[i + 1] == '/') {
+      while (text[i + 1] != '\0' && text[i + 1] != '\n') {
+        i++;
+      }
+    } else if (c == '/' && text[i + 1] == '*') {
+      const char * close = strstr(text + i + 2, "*/");
+      if (close == NULL) {
+        scan.balanced = false;
+        return scan;
+      }
+      i = close - text + 1;
+    } else if (c == '(' || c == '{' || c == '[') {
+      if (depth == 0) {
+        int * first = c == '(' ? &scan.paren : c == '{' ? &scan.brace : &scan.bracket;
+        if (*first < 0) {
+          *first = i;
+        }
+      }
+      depth++;
+    } else if (c == ')' || c == '}' || c == ']') {
+      depth--;
+      if (depth == 0 && c == '}') {
+        scan.last_brace_end = i + 1;
+      }
+    } else if (c == '=' && depth == 0 && scan.equal < 0) {
+      scan.equal = i;
+    }
+  }
+  scan.balanced = depth == 0;
+  return scan;
+}
+
+static const char * repl_skip_spaces(const char * text) {
+  while (isspace((unsigned char)*text)) {
+    text++;
+  }
+  return text;
+}
+
+static size_t repl_trimmed_length(const char * text, size_t length) {
+  while (length > 0 && isspace((unsigned char)text[length - 1])) {
+    length--;
+  }
+  return length;
+}
+
+static char repl_last_char(const char * text, size_t length) {
+  length = repl_trimmed_length(text, length);
+  return length > 0 ? text[length - 1] : '\0';
+}
+
+// Last identifier before `end` (skipping spaces and brackets of declarators)
+static bool repl_name_before(const char * text, int end, char * name) {
+  int i = end;
+  while (i > 0 && !repl_is_identifier_char(text[i - 1])) {
+    i--;
+  }
+  int stop = i;
+  while (i > 0 && repl_is_identifier_char(text[i - 1])) {
+    i--;
+  }
+  if (stop == i || stop - i >= REPL_NAME_SIZE || isdigit((unsigned char)text[i])) {
+    return false;
+  }
+  memcpy(name, text + i, stop - i);
+  name[stop - i] = '\0';
+  return true;
+}
+
+static bool repl_is_complete(const char * text) {
+  const char * start = repl_skip_spaces(text);
+  size_t length = strlen(text);
+  if (start[0] == '#') {
+    return repl_last_char(text, length) != '\\';
+  }
+  repl_scan_t scan = repl_scan(text);
+  char last = repl_last_char(text, length);
+  if (!scan.balanced) {
+    return false;
+  }
+  if (last == ';') {
+    return true;
+  }
+  // A type definition still needs its ';' after the '}'
+  size_t word = repl_identifier_length(start);
+  return last == '}' && !(repl_word_is(start, word, "struct") || repl_word_is(start, word, "union") ||
+                          repl_word_is(start, word, "enum") || repl_word_is(start, word, "typedef"));
+}
+
+static repl_kind_t repl_classify(const char * text, repl_scan_t scan, char * name) {
+  const char * start = repl_skip_spaces(text);
+  size_t word = repl_identifier_length(start);
+  name[0] = '\0';
+
+  if (start[0] == '#') {
+    return REPL_KIND_DIRECTIVE;
+  }
+  if (word == 0 || !repl_is_type_word(start, word) ||
+      repl_word_in(start, word, s_repl_statement_words, sizeof(s_repl_statement_words) / sizeof(s_repl_statement_words[0]))) {
+    return REPL_KIND_STATEMENT;
+  }
+  if (repl_word_is(start, word, "typedef")) {
+    size_t length = strlen(text);
+    while (length > 0 && (isspace((unsigned char)text[length - 1]) || text[length - 1] == ';')) {
+      length--;
+    }
+    repl_name_before(text, length, name);
+    return REPL_KIND_TYPE;
+  }
+  if ((repl_word_is(start, word, "struct") || repl_word_is(start, word, "union") || repl_word_is(start, word, "enum")) &&
+      scan.last_brace_end >= 0 && *repl_skip_spaces(text + scan.last_brace_end) == ';') {
+    return REPL_KIND_TYPE;
+  }
+  if (repl_word_is(start, word, "extern")) {
+    return REPL_KIND_PROTOTYPE;
+  }
+  // A '(' before any '=' is a function: a prototype, or a definition if its body follows
+  if (scan.paren >= 0 && (scan.equal < 0 || scan.paren < scan.equal)) {
+    if (!repl_name_before(text, scan.paren, name)) {
+      return REPL_KIND_STATEMENT;
+    }
+    return scan.brace > scan.paren ? REPL_KIND_FUNCTION : REPL_KIND_PROTOTYPE;
+  }
+  // The declarator ends at the initializer, the array size or the ';'
+  int end = scan.equal >= 0 ? scan.equal : (int)strlen(text);
+  if (scan.bracket >= 0 && scan.bracket < end) {
+    end = scan.bracket;
+  }
+  while (end > 0 && (isspace((unsigned char)text[end - 1]) || text[end - 1] == ';')) {
+    end--;
+  }
+  return repl_name_before(text, end, name) ? REPL_KIND_VARIABLE : REPL_KIND_STATEMENT;
+}
+
+//
+// Session
+//
+
+static bool repl_prelude_append(const char * text, size_t length, const char * suffix) {
+  size_t suffix_length = strlen(suffix);
+  if (s_repl_prelude_length + length + suffix_length + 1 > REPL_PRELUDE_SIZE) {
+    printf("ERR: prelude full, use :reset\n");
+    return false;
+  }
+  memcpy(s_repl_prelude + s_repl_prelude_length, text, length);
+  memcpy(s_repl_prelude + s_repl_prelude_length + length, suffix, suffix_length + 1);
+  s_repl_prelude_length += length + suffix_length;
+  return true;
+}
+
+static void repl_remember_symbol(const char * name, const void * address) {
+  for (int i = 0; i < s_repl_symbol_count; i++) {
+    if (strcmp(s_repl_symbols[i].name, name) == 0) {
+      s_repl_symbols[i].address = address;
+      return;
+    }
+  }
+  if (s_repl_symbol_count < REPL_MAX_SYMBOLS) {
+    strcpy(s_repl_symbols[s_repl_symbol_count].name, name);
+    s_repl_symbols[s_repl_symbol_count++].address = address;
+  } else {
+    printf("WARN: too many symbols, '%s' won't be seen by the next snippets\n", name);
+  }
+}
+
+// Compile the header, the prelude and `body` in a new state, and relocate it.
+// `defined` is left out of the known symbols, since the snippet redefines it.
+static TCCState * repl_compile(const char * body, const char * defined) {
+  if (s_repl_state_count == REPL_MAX_STATES) {
+    printf("ERR: too many snippets, use :reset\n");
+    return NULL;
+  }
+  size_t size = sizeof(s_repl_header) + s_repl_prelude_length + strlen(body) + 1;
+  char * source = malloc(size);
+  if (source == NULL) {
+    printf("ERR: no RAM for the snippet\n");
+    return NULL;
+  }
+  snprintf(source, size, "%s%s%s", s_repl_header, s_repl_prelude, body);
+
+  TCCState * tcc_state = tcc_new();
+  if (!tcc_state) {
+    free(source);
+    return NULL;
+  }
+#ifdef HOST_TCC_LIB_PATH
+  tcc_set_lib_path(tcc_state, HOST_TCC_LIB_PATH);
+#endif
+  tcc_set_error_func(tcc_state, NULL, repl_error_func);
+  tcc_set_output_type(tcc_state, TCC_OUTPUT_MEMORY);
+  // Headers only: the helper library would be defined again by each snippet
+  jit_add_bundle(tcc_state, false);
+  int compiled = tcc_compile_string(tcc_state, source);
+  free(source);
+  if (compiled == -1) {
+    tcc_delete(tcc_state);
+    return NULL;
+  }
+
+  jit_add_symbols(tcc_state);
+  for (size_t i = 0; i < sizeof(s_repl_printers) / sizeof(s_repl_printers[0]); i++) {
+    tcc_add_symbol(tcc_state, s_repl_printers[i].name, s_repl_printers[i].address);
+  }
+  for (int i = 0; i < s_repl_symbol_count; i++) {
+    if (defined == NULL || strcmp(s_repl_symbols[i].name, defined) != 0) {
+      tcc_add_symbol(tcc_state, s_repl_symbols[i].name, s_repl_symbols[i].address);
+    }
+  }
+  if (tcc_relocate(tcc_state) < 0) {
+    tcc_delete(tcc_state);
+    return NULL;
+  }
+
+#ifndef NUMWORKS_HOST
+  // The new code must be fetched from RAM, not from stale caches (see main.c)
+  SCB_CleanDCache();
+  SCB_InvalidateICache();
+#endif
+  s_repl_states[s_repl_state_count++] = tcc_state;
+  return tcc_state;
+}
+
+// Delete the state of the last snippet, which defined nothing the session
+// needs: its blocks go back to the TCC heap (see tcc_stubs.c)
+static void repl_drop_last_state(TCCState * tcc_state) {
+  if (s_repl_state_count > 0 && s_repl_states[s_repl_state_count - 1] == tcc_state) {
+    tcc_delete(s_repl_states[--s_repl_state_count]);
+  }
+}
+
+// Run the wrapped snippet of `tcc_state` on the runner stack
+static repl_status_t repl_run(TCCState * tcc_state) {
+  runner_main_t entry = (runner_main_t)tcc_get_symbol(tcc_state, REPL_EVAL_NAME);
+  if (!entry) {
+    return REPL_ERROR;
+  }
+  runner_report_t report;
+  runner_run(entry, 0, &report);
+  if (report.budget_exceeded) {
+    printf("ERR: stopped after %lums (budget)\n", (unsigned long)runner_budget_ms());
+    return REPL_ERROR;
+  }
+  if (report.stack_overflow) {
+    printf("ERR: stack overflow (guard overwritten)\n");
+    return REPL_ERROR;
+  }
+  return REPL_OK;
+}
+
+static repl_status_t repl_statement(const char * text) {
+  size_t length = strlen(text);
+  char * body = malloc(length + 64);
+  if (body == NULL) {
+    return REPL_ERROR;
+  }
+
+  // An expression has its value printed: try that first, quietly, and fall
+  // back on a plain statement (void calls, declarations of locals, loops...)
+  TCCState * tcc_state = NULL;
+  const char * start = repl_skip_spaces(text);
+  size_t word = repl_identifier_length(start);
+  if (!repl_word_in(start, word, s_repl_statement_words, sizeof(s_repl_statement_words) / sizeof(s_repl_statement_words[0])) &&
+      start[0] != '{') {
+    size_t expression_length = length;
+    while (expression_length > 0 && (isspace((unsigned char)text[expression_length - 1]) || text[expression_length - 1] == ';')) {
+      expression_length--;
+    }
+    snprintf(body, length + 64, "int " REPL_EVAL_NAME "(int arg) { __repl_print(%.*s); return 0; }\n",
+             (int)expression_length, text);
+    s_repl_quiet = true;
+    tcc_state = repl_compile(body, NULL);
+    s_repl_quiet = false;
+  }
+  if (tcc_state == NULL) {
+    snprintf(body, length + 64, "int " REPL_EVAL_NAME "(int arg) {\n%s\nreturn 0; }\n", text);
+    tcc_state = repl_compile(body, NULL);
+  }
+  free(body);
+  if (tcc_state == NULL) {
+    return REPL_ERROR;
+  }
+  repl_status_t status = repl_run(tcc_state);
+  // Its code and data are not needed anymore, unless a string literal or a
+  // static local was stored somewhere the next snippets can see it
+  if (strchr(text, '"') == NULL && strstr(text, "static") == NULL) {
+    repl_drop_last_state(tcc_state);
+  }
+  return status;
+}
+
+// Strip a leading "static", so that the definition is seen by the next snippets
+static const char * repl_skip_static(const char * text) {
+  const char * start = repl_skip_spaces(text);
+  size_t word = repl_identifier_length(start);
+  return repl_word_is(start, word, "static") ? repl_skip_spaces(start + word) : text;
+}
+
+static repl_status_t repl_definition(const char * text, repl_kind_t kind, const char * name) {
+  if (kind == REPL_KIND_FUNCTION || kind == REPL_KIND_VARIABLE) {
+    text = repl_skip_static(text);
+  }
+  repl_scan_t scan = repl_scan(text);
+
+  TCCState * tcc_state = repl_compile(text, kind == REPL_KIND_FUNCTION || kind == REPL_KIND_VARIABLE ? name : NULL);
+  if (tcc_state == NULL) {
+    return REPL_ERROR;
+  }
+
+  if (kind != REPL_KIND_FUNCTION && kind != REPL_KIND_VARIABLE) {
+    // Compiled only to check it: the prelude keeps it for the next snippets
+    repl_drop_last_state(tcc_state);
+  }
+
+  switch (kind) {
+    case REPL_KIND_DIRECTIVE:
+      return repl_prelude_append(text, repl_trimmed_length(text, strlen(text)), "\n") ? REPL_OK : REPL_ERROR;
+    case REPL_KIND_TYPE:
+    case REPL_KIND_PROTOTYPE:
+      if (name[0] != '\0' && s_repl_typedef_count < REPL_MAX_SYMBOLS && strncmp(repl_skip_spaces(text), "typedef", 7) == 0) {
+        strcpy(s_repl_typedefs[s_repl_typedef_count++], name);
+      }
+      return repl_prelude_append(text, repl_trimmed_length(text, strlen(text)), "\n") ? REPL_OK : REPL_ERROR;
+    case REPL_KIND_FUNCTION: {
+      const void * address = tcc_get_symbol(tcc_state, name);
+      if (address == NULL) {
+        return REPL_ERROR;
+      }
+      repl_remember_symbol(name, address);
+      // The prototype is everything before the body
+      return repl_prelude_append(text, repl_trimmed_length(text, scan.brace), ";\n") ? REPL_OK : REPL_ERROR;
+    }
+    case REPL_KIND_VARIABLE: {
+      const void * address = tcc_get_symbol(tcc_state, name);
+      if (address == NULL) {
+        return REPL_ERROR;
+      }
+      repl_remember_symbol(name, address);
+      // The declaration is everything before the initializer
+      size_t length = scan.equal >= 0 ? (size_t)scan.equal : strlen(text);
+      while (length > 0 && (isspace((unsigned char)text[length - 1]) || text[length - 1] == ';')) {
+        length--;
+      }
+      return repl_prelude_append("extern ", 7, "") && repl_prelude_append(text, length, ";\n") ? REPL_OK : REPL_ERROR;
+    }
+    default:
+      return REPL_ERROR;
+  }
+}
+
+static repl_status_t repl_command(const char * command) {
+  if (strncmp(command, ":reset", 6) == 0) {
+    repl_reset();
+    printf("Session reset, %zuKB free\n", tcc_numworks_heap_size() / 1024);
+  } else if (strncmp(command, ":defs", 5) == 0) {
+    printf("%s", s_repl_prelude);
+  } else if (strncmp(command, ":symbols", 8) == 0) {
+    for (int i = 0; i < s_repl_symbol_count; i++) {
+      printf("%s = %p\n", s_repl_symbols[i].name, s_repl_symbols[i].address);
+    }
+    printf("%d states kept, TCC heap %zuB\n", s_repl_state_count, tcc_numworks_heap_used());
+  } else {
+    printf("Commands: :reset :defs :symbols\n");
+  }
+  return REPL_COMMAND;
+}
+
+repl_status_t repl_feed(const char * line) {
+  const char * start = repl_skip_spaces(line);
+  if (s_repl_input_length == 0 && start[0] == ':') {
+    return repl_command(start);
+  }
+  if (s_repl_input_length == 0 && start[0] == '\0') {
+    return REPL_MORE;
+  }
+
+  size_t length = strlen(line);
+  if (s_repl_input_length + length + 2 > REPL_INPUT_SIZE) {
+    printf("ERR: snippet too long\n");
+    s_repl_input_length = 0;
+    return REPL_ERROR;
+  }
+  memcpy(s_repl_input + s_repl_input_length, line, length);
+  s_repl_input_length += length;
+  s_repl_input[s_repl_input_length++] = '\n';
+  s_repl_input[s_repl_input_length] = '\0';
+  if (!repl_is_complete(s_repl_input)) {
+    return REPL_MORE;
+  }
+  s_repl_input_length = 0;
+
+  char name[REPL_NAME_SIZE];
+  repl_kind_t kind = repl_classify(s_repl_input, repl_scan(s_repl_input), name);
+  if (kind == REPL_KIND_STATEMENT) {
+    return repl_statement(s_repl_input);
+  }
+  return repl_definition(s_repl_input, kind, name);
+}
@@ -0,0 +1,75 @@
+//
+// Interactive mode: compile and run C snippets one at a time
+//
+// libtcc can't add code to a state once it's relocated, so each snippet gets
+// its own TCC state. The states of the snippets that define functions or
+// global variables are kept alive with their code for the whole session. The
+// session remembers what the snippets defined:
+//
+//  - a prelude of declarations (prototypes, extern variables, typedefs,
+//    struct definitions, #include and #define lines), compiled before each
+//    new snippet,
+//  - the address of each function and global variable, added to each new
+//    state with tcc_add_symbol().
+//
+// A snippet that is neither a definition nor a declaration is run right away,
+// and if it's an expression its value is printed.
+//
+// The other states hold nothing the next snippets need: they are deleted once
+// compiled (declarations) or run (statements), and the TCC heap reuses their
+// blocks (see tcc_stubs.c). A statement that stores a string literal or the
+// address of a static local in a global variable keeps its state, since these
+// live in its data. ":reset" deletes every state and frees the whole heap.
+//
+#ifndef REPL_H
+#define REPL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "libtcc.h" // for TCCErrorFunc
+
+// Build the app as a REPL, reading snippets from the keyboard
+#ifndef TCC_REPL
+#define TCC_REPL 0
+#endif
+
+// Longest snippet, once its lines are joined
+#define REPL_INPUT_SIZE 1024
+// Total size of the prelude of declarations
+#define REPL_PRELUDE_SIZE 4096
+// Functions and global variables remembered by the session
+#define REPL_MAX_SYMBOLS 64
+#define REPL_NAME_SIZE 32
+
+typedef enum {
+  REPL_MORE,    // The snippet isn't complete yet (unbalanced braces, or no ';')
+  REPL_OK,      // Compiled (and run, if it was a statement)
+  REPL_ERROR,   // Didn't compile, or didn't run to the end
+  REPL_COMMAND, // A ':' command of the REPL itself
+} repl_status_t;
+
+// Start a session, diagnostics of TCC go to error_func
+void repl_init(TCCErrorFunc error_func, void * error_opaque);
+
+// Forget every snippet, and free the TCC heap
+void repl_reset(void);
+
+// Add one line to the current snippet, and compile it once it's complete.
+// Commands: ":reset", ":defs" (print the prelude), ":symbols"
+repl_status_t repl_feed(const char * line);
+
+// True while a snippet spans several lines
+bool repl_pending(void);
+
+// Number of snippets compiled since the last reset
+int repl_snippet_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,84 @@
+//
+// Line editor on the calculator keyboard, for the REPL (see repl_keyboard.h)
+//
+#include "repl_keyboard.h"
+#include <eadk.h>
+#include <stdio.h>
+
+typedef struct {
+  eadk_event_t event;
+  char c;
+} repl_key_t;
+
+// The EADK already applies shift and alpha: each event is one character
+static const repl_key_t s_repl_keys[] = {
+  {eadk_event_zero, '0'}, {eadk_event_one, '1'}, {eadk_event_two, '2'}, {eadk_event_three, '3'},
+  {eadk_event_four, '4'}, {eadk_event_five, '5'}, {eadk_event_six, '6'}, {eadk_event_seven, '7'},
+  {eadk_event_eight, '8'}, {eadk_event_nine, '9'},
+  {eadk_event_addition, '+'}, {eadk_event_subtraction, '-'}, {eadk_event_multiplication, '*'},
+  {eadk_event_division, '/'}, {eadk_event_dot, '.'}, {eadk_event_comma, ','},
+  {eadk_event_left_parenthesis, '('}, {eadk_event_right_parenthesis, ')'},
+  {eadk_event_left_bracket, '['}, {eadk_event_right_bracket, ']'},
+  {eadk_event_left_brace, '{'}, {eadk_event_right_brace, '}'},
+  {eadk_event_colon, ':'}, {eadk_event_semicolon, ';'}, {eadk_event_double_quotes, '"'},
+  {eadk_event_percent, '%'}, {eadk_event_underscore, '_'}, {eadk_event_equal, '='},
+  {eadk_event_lower, '<'}, {eadk_event_greater, '>'}, {eadk_event_question, '?'},
+  {eadk_event_exclamation, '!'}, {eadk_event_space, ' '}, {eadk_event_sto, '='},
+  {eadk_event_lower_a, 'a'}, {eadk_event_lower_b, 'b'}, {eadk_event_lower_c, 'c'}, {eadk_event_lower_d, 'd'},
+  {eadk_event_lower_e, 'e'}, {eadk_event_lower_f, 'f'}, {eadk_event_lower_g, 'g'}, {eadk_event_lower_h, 'h'},
+  {eadk_event_lower_i, 'i'}, {eadk_event_lower_j, 'j'}, {eadk_event_lower_k, 'k'}, {eadk_event_lower_l, 'l'},
+  {eadk_event_lower_m, 'm'}, {eadk_event_lower_n, 'n'}, {eadk_event_lower_o, 'o'}, {eadk_event_lower_p, 'p'},
+  {eadk_event_lower_q, 'q'}, {eadk_event_lower_r, 'r'}, {eadk_event_lower_s, 's'}, {eadk_event_lower_t, 't'},
+  {eadk_event_lower_u, 'u'}, {eadk_event_lower_v, 'v'}, {eadk_event_lower_w, 'w'}, {eadk_event_lower_x, 'x'},
+  {eadk_event_lower_y, 'y'}, {eadk_event_lower_z, 'z'},
+  {eadk_event_upper_a, 'A'}, {eadk_event_upper_b, 'B'}, {eadk_event_upper_c, 'C'}, {eadk_event_upper_d, 'D'},
+  {eadk_event_upper_e, 'E'}, {eadk_event_upper_f, 'F'}, {eadk_event_upper_g, 'G'}, {eadk_event_upper_h, 'H'},
+  {eadk_event_upper_i, 'I'}, {eadk_event_upper_j, 'J'}, {eadk_event_upper_k, 'K'}, {eadk_event_upper_l, 'L'},
+  {eadk_event_upper_m, 'M'}, {eadk_event_upper_n, 'N'}, {eadk_event_upper_o, 'O'}, {eadk_event_upper_p, 'P'},
+  {eadk_event_upper_q, 'Q'}, {eadk_event_upper_r, 'R'}, {eadk_event_upper_s, 'S'}, {eadk_event_upper_t, 'T'},
+  {eadk_event_upper_u, 'U'}, {eadk_event_upper_v, 'V'}, {eadk_event_upper_w, 'W'}, {eadk_event_upper_x, 'X'},
+  {eadk_event_upper_y, 'Y'}, {eadk_event_upper_z, 'Z'},
+};
+
+static char repl_keyboard_char(eadk_event_t event) {
+  for (size_t i = 0; i < sizeof(s_repl_keys) / sizeof(s_repl_keys[0]); i++) {
+    if (s_repl_keys[i].event == event) {
+      return s_repl_keys[i].c;
+    }
+  }
+  return '\0';
+}
+
+bool repl_keyboard_read_line(const char * prompt, char * line, size_t size) {
+  size_t length = 0;
+  line[0] = '\0';
+  printf("%s", prompt);
+  fflush(stdout);
+  for (;;) {
+    int32_t timeout = 100000;
+    eadk_event_t event = eadk_event_get(&timeout);
+    if (event == eadk_event_exe || event == eadk_event_ok) {
+      printf("\n");
+      return true;
+    }
+    if (event == eadk_event_back) {
+      printf("\n");
+      return false;
+    }
+    if (event == eadk_event_backspace) {
+      if (length > 0) {
+        line[--length] = '\0';
+        printf("\b \b");
+        fflush(stdout);
+      }
+      continue;
+    }
+    char c = repl_keyboard_char(event);
+    if (c != '\0' && length + 1 < size) {
+      line[length++] = c;
+      line[length] = '\0';
+      printf("%c", c);
+      fflush(stdout);
+    }
+  }
+}
@@ -0,0 +1,15 @@
+//
+// Line editor on the calculator keyboard, for the REPL (see repl.h)
+//
+#ifndef REPL_KEYBOARD_H
+#define REPL_KEYBOARD_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// Print `prompt`, then read keys until EXE or OK (returns true, with the line
+// in `line`) or Back (returns false, to leave the REPL).
+// Type letters and symbols with the usual shift and alpha keys.
+bool repl_keyboard_read_line(const char * prompt, char * line, size_t size);
+
+#endif
@@ -0,0 +1,349 @@
+//
+// Runs the main() of the compiled program on its own stack (see runner.h)
+//
+#include "runner.h"
+#include <eadk.h>
+#include <string.h>
+#include <setjmp.h>
+
+#ifdef NUMWORKS_HOST
+#include <signal.h>
+#include <sys/time.h>
+#include <time.h>
+#include <ucontext.h>
+#else
+#define STM32F730xx
+#include "stm32f7xx.h"
+#endif
+
+// Words of the untouched stack, and of the guard below it
+#define RUNNER_STACK_PAINT 0x5A5A5A5Au
+#define RUNNER_STACK_CANARY 0xDEADBEEFu
+
+#define RUNNER_STACK_WORDS ((RUNNER_STACK_GUARD_SIZE + RUNNER_STACK_SIZE) / sizeof(uint32_t))
+#define RUNNER_GUARD_WORDS (RUNNER_STACK_GUARD_SIZE / sizeof(uint32_t))
+
+// An MPU region must be aligned on its size, and the stack on 8 bytes
+// It's uninitialized, so it goes into .bss (saving flash space).
+static uint32_t s_runner_stack[RUNNER_STACK_WORDS] __attribute__((aligned(RUNNER_STACK_GUARD_SIZE)));
+
+static uint32_t s_runner_budget_ms = RUNNER_BUDGET_MS;
+
+// Where the program jumps back when its budget runs out
+#ifdef NUMWORKS_HOST
+static sigjmp_buf s_runner_abort;
+#else
+static jmp_buf s_runner_abort;
+#endif
+
+void runner_set_budget_ms(uint32_t budget_ms) {
+  s_runner_budget_ms = budget_ms;
+}
+
+uint32_t runner_budget_ms(void) {
+  return s_runner_budget_ms;
+}
+
+static void runner_paint_stack(void) {
+  for (size_t i = 0; i < RUNNER_GUARD_WORDS; i++) {
+    s_runner_stack[i] = RUNNER_STACK_CANARY;
+  }
+  for (size_t i = RUNNER_GUARD_WORDS; i < RUNNER_STACK_WORDS; i++) {
+    s_runner_stack[i] = RUNNER_STACK_PAINT;
+  }
+}
+
+static bool runner_guard_is_intact(void) {
+  for (size_t i = 0; i < RUNNER_GUARD_WORDS; i++) {
+    if (s_runner_stack[i] != RUNNER_STACK_CANARY) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The stack grows down, so the lowest word that isn't paint anymore gives the peak
+static size_t runner_stack_peak(void) {
+  size_t i = RUNNER_GUARD_WORDS;
+  while (i < RUNNER_STACK_WORDS && s_runner_stack[i] == RUNNER_STACK_PAINT) {
+    i++;
+  }
+  return (RUNNER_STACK_WORDS - i) * sizeof(uint32_t);
+}
+
+#ifdef NUMWORKS_HOST
+
+static ucontext_t s_runner_caller_context;
+static ucontext_t s_runner_program_context;
+static runner_main_t s_runner_entry;
+static int s_runner_arg;
+static int s_runner_ret;
+static struct timespec s_runner_start;
+
+static void runner_trampoline(void) {
+  s_runner_ret = s_runner_entry(s_runner_arg);
+}
+
+static int runner_call_on_stack(runner_main_t entry, int arg) {
+  s_runner_entry = entry;
+  s_runner_arg = arg;
+  getcontext(&s_runner_program_context);
+  s_runner_program_context.uc_stack.ss_sp = &s_runner_stack[RUNNER_GUARD_WORDS];
+  s_runner_program_context.uc_stack.ss_size = RUNNER_STACK_SIZE;
+  s_runner_program_context.uc_link = &s_runner_caller_context;
+  makecontext(&s_runner_program_context, runner_trampoline, 0);
+  swapcontext(&s_runner_caller_context, &s_runner_program_context);
+  return s_runner_ret;
+}
+
+// No MPU on the host, the canary words are the only guard
+static void runner_guard_enable(void) { }
+static void runner_guard_disable(void) { }
+
+const char * runner_mode(void) {
+  return "host: canary guard, SIGALRM budget";
+}
+
+static void runner_budget_signal(int signal) {
+  (void)signal;
+  siglongjmp(s_runner_abort, 1);
+}
+
+static void runner_clock_start(void) {
+  if (s_runner_budget_ms > 0) {
+    signal(SIGALRM, runner_budget_signal);
+    struct itimerval timer = {{0, 0}, {s_runner_budget_ms / 1000, (s_runner_budget_ms % 1000) * 1000}};
+    setitimer(ITIMER_REAL, &timer, NULL);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &s_runner_start);
+}
+
+static void runner_clock_stop(uint64_t * cycles, uint64_t * wall_us) {
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  struct itimerval off = {{0, 0}, {0, 0}};
+  setitimer(ITIMER_REAL, &off, NULL);
+
+  uint64_t ns = (uint64_t)(end.tv_sec - s_runner_start.tv_sec) * 1000000000u
+              + end.tv_nsec - s_runner_start.tv_nsec;
+  *wall_us = ns / 1000;
+  *cycles = ns * (RUNNER_CPU_HZ / 1000000u) / 1000u;
+}
+
+#else
+
+// Call entry(arg) with sp at stack_top, and restore the app sp on return.
+// r4 is callee-saved, so it keeps the app sp across the call.
+__attribute__((naked, noinline))
+static int runner_switch_stack(int arg, runner_main_t entry, void * stack_top) {
+  __asm volatile(
+    "push {r4, lr}\n"
+    "mov r4, sp\n"
+    "mov sp, r2\n"
+    "blx r1\n"
+    "mov sp, r4\n"
+    "pop {r4, pc}\n"
+  );
+}
+
+static int runner_call_on_stack(runner_main_t entry, int arg) {
+  return runner_switch_stack(arg, entry, &s_runner_stack[RUNNER_STACK_WORDS]);
+}
+
+// An external app isn't guaranteed to run privileged: then writing to the
+// MPU, VTOR or DWT would fault, so only the canary guard is used, without
+// budget, and the run is timed with the millisecond clock
+static bool s_runner_privileged;
+
+static bool runner_is_privileged(void) {
+  return (__get_CONTROL() & CONTROL_nPRIV_Msk) == 0;
+}
+
+const char * runner_mode(void) {
+  if (!runner_is_privileged()) {
+    return "unprivileged: canary guard, no budget";
+  }
+  return RUNNER_MPU_GUARD ? "MPU guard, SysTick budget" : "canary guard, SysTick budget";
+}
+
+#if RUNNER_MPU_GUARD
+static uint32_t s_runner_saved_rbar;
+static uint32_t s_runner_saved_rasr;
+static uint32_t s_runner_saved_ctrl;
+#endif
+
+static void runner_guard_enable(void) {
+#if RUNNER_MPU_GUARD
+  if (!s_runner_privileged) {
+    return;
+  }
+  // Save the region we borrow, the OS may be using it
+  MPU->RNR = RUNNER_MPU_REGION;
+  s_runner_saved_rbar = MPU->RBAR;
+  s_runner_saved_rasr = MPU->RASR;
+  s_runner_saved_ctrl = MPU->CTRL;
+
+  ARM_MPU_Disable();
+  ARM_MPU_SetRegion(
+    ARM_MPU_RBAR(RUNNER_MPU_REGION, (uint32_t)s_runner_stack),
+    ARM_MPU_RASR(1, ARM_MPU_AP_NONE, 0, 0, 0, 0, 0, ARM_MPU_REGION_SIZE_32B));
+  // Keep the default memory map for everything else
+  ARM_MPU_Enable(s_runner_saved_ctrl | MPU_CTRL_PRIVDEFENA_Msk);
+#endif
+}
+
+static void runner_guard_disable(void) {
+#if RUNNER_MPU_GUARD
+  if (!s_runner_privileged) {
+    return;
+  }
+  ARM_MPU_Disable();
+  ARM_MPU_SetRegion(s_runner_saved_rbar | MPU_RBAR_VALID_Msk | RUNNER_MPU_REGION, s_runner_saved_rasr);
+  if (s_runner_saved_ctrl & MPU_CTRL_ENABLE_Msk) {
+    ARM_MPU_Enable(s_runner_saved_ctrl);
+  }
+#endif
+}
+
+// Copy of the vector table with our SysTick handler, installed during the run
+static uint32_t s_runner_vectors[RUNNER_VECTOR_COUNT] __attribute__((aligned(RUNNER_VECTOR_COUNT * 4)));
+static uint32_t s_runner_saved_vtor;
+static void (*s_runner_original_systick)(void);
+
+static volatile bool s_runner_in_program = false;
+static uint64_t s_runner_budget_cycles;
+static uint64_t s_runner_cycles;
+static uint32_t s_runner_last_cyccnt;
+static uint64_t s_runner_start_ms;
+
+// CYCCNT wraps every ~20 s at 216 MHz, so it's accumulated on each tick
+static void runner_accumulate_cycles(void) {
+  uint32_t now = DWT->CYCCNT;
+  s_runner_cycles += (uint32_t)(now - s_runner_last_cyccnt);
+  s_runner_last_cyccnt = now;
+}
+
+static void runner_budget_abort(void) {
+  longjmp(s_runner_abort, 1);
+}
+
+// Called by runner_systick_handler with the exception frame of the
+// interrupted code. Returning from here returns from the exception.
+__attribute__((used, externally_visible))
+void runner_systick_check(uint32_t * frame, uint32_t exc_return) {
+  s_runner_original_systick();
+  runner_accumulate_cycles();
+
+  // Only divert the program itself: not the handlers it may have preempted
+  // (EXC_RETURN bit 3 set means we return to thread mode)
+  if (s_runner_in_program && s_runner_budget_cycles > 0 &&
+      s_runner_cycles >= s_runner_budget_cycles && (exc_return & 0x8)) {
+    s_runner_in_program = false;
+    // Resume in runner_budget_abort instead: stacked PC, and xPSR with the
+    // Thumb bit set and the IT/ICI bits cleared
+    frame[6] = (uint32_t)runner_budget_abort & ~1u;
+    frame[7] = (frame[7] & ~0x0600FC00u) | (1u << 24);
+  }
+}
+
+// Pass the frame of the interrupted code (on MSP or PSP, EXC_RETURN bit 2)
+// and EXC_RETURN to runner_systick_check, which keeps lr to return
+__attribute__((naked))
+static void runner_systick_handler(void) {
+  __asm volatile(
+    "tst lr, #4\n"
+    "ite eq\n"
+    "mrseq r0, msp\n"
+    "mrsne r0, psp\n"
+    "mov r1, lr\n"
+    "b runner_systick_check\n"
+  );
+}
+
+static void runner_clock_start(void) {
+  s_runner_start_ms = eadk_timing_millis();
+  if (!s_runner_privileged) {
+    return;
+  }
+
+  // Start the cycle counter
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->LAR = 0xC5ACCE55; // Unlock the DWT on Cortex-M7
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  s_runner_cycles = 0;
+  s_runner_budget_cycles = (uint64_t)s_runner_budget_ms * (RUNNER_CPU_HZ / 1000u);
+
+  // Hook SysTick through a copy of the vector table
+  __disable_irq();
+  s_runner_saved_vtor = SCB->VTOR;
+  memcpy(s_runner_vectors, (const void *)s_runner_saved_vtor, sizeof(s_runner_vectors));
+  s_runner_original_systick = (void (*)(void))s_runner_vectors[SysTick_IRQn + 16];
+  s_runner_vectors[SysTick_IRQn + 16] = (uint32_t)runner_systick_handler;
+  __DSB();
+  SCB->VTOR = (uint32_t)s_runner_vectors;
+  __DSB();
+  __ISB();
+
+  s_runner_last_cyccnt = DWT->CYCCNT;
+  s_runner_in_program = true;
+  __enable_irq();
+}
+
+static void runner_clock_stop(uint64_t * cycles, uint64_t * wall_us) {
+  *wall_us = (eadk_timing_millis() - s_runner_start_ms) * 1000;
+  if (!s_runner_privileged) {
+    // Estimated from the elapsed time, like on the host
+    *cycles = *wall_us * (RUNNER_CPU_HZ / 1000000u);
+    return;
+  }
+
+  __disable_irq();
+  s_runner_in_program = false;
+  runner_accumulate_cycles();
+  SCB->VTOR = s_runner_saved_vtor;
+  __DSB();
+  __ISB();
+  __enable_irq();
+
+  *cycles = s_runner_cycles;
+}
+
+#endif
+
+int runner_run(runner_main_t entry, int arg, runner_report_t * report) {
+  runner_paint_stack();
+
+  // volatile, since they are read again after a longjmp
+  volatile int ret = RUNNER_ABORTED;
+  volatile bool aborted = true;
+
+#ifndef NUMWORKS_HOST
+  s_runner_privileged = runner_is_privileged();
+#endif
+  runner_guard_enable();
+#ifdef NUMWORKS_HOST
+  if (sigsetjmp(s_runner_abort, 1) == 0) {
+#else
+  if (setjmp(s_runner_abort) == 0) {
+#endif
+    // Only armed once there is somewhere to jump back to
+    runner_clock_start();
+    ret = runner_call_on_stack(entry, arg);
+    aborted = false;
+  }
+  uint64_t cycles;
+  uint64_t wall_us;
+  runner_clock_stop(&cycles, &wall_us);
+  runner_guard_disable();
+
+  if (report != NULL) {
+    report->stack_size = RUNNER_STACK_SIZE;
+    report->stack_peak = runner_stack_peak();
+    report->stack_overflow = !runner_guard_is_intact();
+    report->cycles = cycles;
+    report->wall_us = wall_us;
+    report->budget_exceeded = aborted;
+  }
+  return ret;
+}
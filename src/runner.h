@@ -0,0 +1,94 @@
+//
+// Runs the main() of the compiled program on its own stack
+//
+// The program doesn't run on the app stack (which sits right next to .bss and
+// the TCC heap) but on a dedicated region, painted beforehand so that its peak
+// usage can be measured after return. Below the region, a guard catches
+// overflows: an MPU no-access region on the calculator, canary words on both
+// the calculator and the host.
+//
+// The run is timed with the DWT cycle counter (on the host, the monotonic
+// clock), and an optional budget stops runaway programs: once it's spent, the
+// SysTick interrupt (on the host, SIGALRM) makes the program jump back into
+// runner_run(). The MPU guard and the budget are skipped when the app doesn't
+// run privileged (see runner_mode()).
+//
+#ifndef RUNNER_H
+#define RUNNER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Size of the stack given to the compiled program, tune it with the peak
+// usage reported by runner_run()
+#ifndef RUNNER_STACK_SIZE
+#ifdef NUMWORKS_HOST
+#define RUNNER_STACK_SIZE (64 * 1024) // Host libc calls need much more stack
+#else
+#define RUNNER_STACK_SIZE (8 * 1024)
+#endif
+#endif
+
+// Guard below the stack: 32 bytes is the smallest MPU region
+#define RUNNER_STACK_GUARD_SIZE 32
+
+// Enable the MPU guard region on the calculator (needs privileged mode)
+#ifndef RUNNER_MPU_GUARD
+#define RUNNER_MPU_GUARD 1
+#endif
+// Highest region number wins on overlaps, so take the last of the 8 regions
+#define RUNNER_MPU_REGION 7
+
+// Default budget of the compiled program, in milliseconds: 0 for no limit, so
+// that long drawing loops keep running. Set it with `make RUNNER_BUDGET_MS=...`
+// or runner_set_budget_ms().
+#ifndef RUNNER_BUDGET_MS
+#define RUNNER_BUDGET_MS 0
+#endif
+
+// Core clock of the N0110/N0120 STM32F7, used to convert budgets to cycles,
+// and on the host to give cycles from the elapsed time
+#define RUNNER_CPU_HZ 216000000u
+
+// Size of the vector table copy installed during the run on the calculator:
+// 16 system exceptions and the 98 interrupts of the STM32F7, rounded up to
+// a power of two since VTOR must be aligned on the table size
+#define RUNNER_VECTOR_COUNT 128
+
+// Returned by runner_run() when the budget ran out
+#define RUNNER_ABORTED (-1)
+
+typedef int (*runner_main_t)(int);
+
+typedef struct {
+  size_t stack_size;    // Usable stack size, in bytes
+  size_t stack_peak;    // Maximum stack usage seen after return, in bytes
+  bool stack_overflow;  // The guard below the stack was written to
+  uint64_t cycles;      // Cycles spent in the program (estimated on the host)
+  uint64_t wall_us;     // Wall time spent in the program (ms precision on the calculator)
+  bool budget_exceeded; // The program was stopped by the budget
+} runner_report_t;
+
+// Change the budget of the next runs, in milliseconds (0 for no limit)
+void runner_set_budget_ms(uint32_t budget_ms);
+// Budget in effect, in milliseconds (0 for no limit)
+uint32_t runner_budget_ms(void);
+
+// Guard and budget used by runner_run(), to print: the MPU guard and the
+// SysTick budget need the app to run privileged on the calculator
+const char * runner_mode(void);
+
+// Call entry(arg) on the dedicated stack, and fill `report` if not NULL.
+// Returns RUNNER_ABORTED if the budget ran out.
+int runner_run(runner_main_t entry, int arg, runner_report_t * report);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -9,19 +9,28 @@
 
 // Taken from https://codereview.stackexchange.com/questions/151049/endianness-conversion-in-c/151070#151070
 // I could convert the endianness manually, but it's less readable.
-inline uint32_t reverse32(uint32_t value) {
+static inline uint32_t reverse32(uint32_t value) {
   return (((value & 0x000000FF) << 24) |
           ((value & 0x0000FF00) <<  8) |
           ((value & 0x00FF0000) >>  8) |
           ((value & 0xFF000000) >> 24));
 }
 
+// Each record starts with its size (2 bytes, including the size itself and the
+// name). Records are packed, so it's not aligned: read it with memcpy.
+static inline uint16_t recordSize(const char * record) {
+  uint16_t size;
+  memcpy(&size, record, sizeof(size));
+  return size;
+}
+
 
 // This function takes extension for compatibility reasons, but ignores it
 int extapp_fileList(const char ** filename, int maxrecord, const char * extension) {
+  (void)extension;
   uint32_t storageAddress = extapp_address();
-  char * offset = (char *)storageAddress;
-  const char * endAddress = (char *)extapp_size() + storageAddress;
+  char * offset = (char *)(uintptr_t)storageAddress;
+  const char * endAddress = (char *)(uintptr_t)storageAddress + extapp_size();
 
   if (!extapp_isValid((const uint32_t *)offset)) {
     // Storage is invalid
@@ -33,7 +42,7 @@ int extapp_fileList(const char ** filename, int maxrecord, const char * extensio
 
 
   while ((currentRecord < maxrecord) && offset < endAddress) {
-    uint16_t size = *(uint16_t *)offset;
+    uint16_t size = recordSize(offset);
     if (size == 0) {
       break;
     }
@@ -49,8 +58,8 @@ int extapp_fileList(const char ** filename, int maxrecord, const char * extensio
 
 int extapp_fileListWithExtension(const char ** filename, int maxrecord, const char * extension_to_match) {
   uint32_t storageAddress = extapp_address();
-  char * offset = (char *)storageAddress;
-  const char * endAddress = (char *)extapp_size() + storageAddress;
+  char * offset = (char *)(uintptr_t)storageAddress;
+  const char * endAddress = (char *)(uintptr_t)storageAddress + extapp_size();
 
   if (!extapp_isValid((const uint32_t *)offset)) {
     // Storage is invalid
@@ -62,14 +71,14 @@ int extapp_fileListWithExtension(const char ** filename, int maxrecord, const ch
 
 
   while ((currentRecord < maxrecord) && offset < endAddress) {
-    uint16_t size = *(uint16_t *)offset;
+    uint16_t size = recordSize(offset);
     if (size == 0) {
       break;
     }
     char * name = offset + 2;
 
-    char * extension = strrchr(name, '.') + 1;
-    if (strcmp(extension, extension_to_match) == 0) {
+    const char * dot = strrchr(name, '.');
+    if (dot != NULL && strcmp(dot + 1, extension_to_match) == 0) {
       filename[currentRecord] = name;
       currentRecord++;
     }
@@ -82,8 +91,8 @@ int extapp_fileListWithExtension(const char ** filename, int maxrecord, const ch
 
 bool extapp_fileExists(const char * filename) {
   uint32_t storageAddress = extapp_address();
-  char * offset = (char *)storageAddress;
-  const char * endAddress = (char *)extapp_size() + storageAddress;
+  char * offset = (char *)(uintptr_t)storageAddress;
+  const char * endAddress = (char *)(uintptr_t)storageAddress + extapp_size();
 
   if (!extapp_isValid((const uint32_t *)offset)) {
     // Storage is invalid
@@ -95,7 +104,7 @@ bool extapp_fileExists(const char * filename) {
 
 
   while (offset < endAddress) {
-    uint16_t size = *(uint16_t *)offset;
+    uint16_t size = recordSize(offset);
     if (size == 0) {
       break;
     }
@@ -115,8 +124,8 @@ bool extapp_fileExists(const char * filename) {
 
 const char * extapp_fileRead(const char * filename, size_t * len) {
   uint32_t storageAddress = extapp_address();
-  char * offset = (char *)storageAddress;
-  const char * endAddress = (char *)extapp_size() + storageAddress;
+  char * offset = (char *)(uintptr_t)storageAddress;
+  const char * endAddress = (char *)(uintptr_t)storageAddress + extapp_size();
 
   if (!extapp_isValid((const uint32_t *)offset)) {
     // Storage is invalid
@@ -126,7 +135,7 @@ const char * extapp_fileRead(const char * filename, size_t * len) {
   offset += 4;
 
   while (offset < endAddress) {
-    uint16_t size = *(uint16_t *)offset;
+    uint16_t size = recordSize(offset);
     if (size == 0) {
       break;
     }
@@ -149,40 +158,50 @@ const char * extapp_fileRead(const char * filename, size_t * len) {
   return NULL;
 }
 
-bool extapp_fileWrite(const char * filename, const char * content, size_t len) {
-  // Check if we have enough free space
-  const uint32_t * recordStartPointer = extapp_nextFree();
-  //                                                          Start Address  + size +     filename     + \0 + content
-  const uint32_t * recordEndPointer = (uint32_t *)((char *)recordStartPointer + strlen(filename) + 1 + len);
-  const uint32_t * storageEndPointer = (uint32_t *)(size_t)((void *)extapp_address() + extapp_size());
-
-  // In case where we have overflown storage, we return an error
-  if (storageEndPointer < recordEndPointer) {
-    return false;
+// Append the header of a record (size and name) for `len` bytes of content,
+// and return where the content goes, or NULL if it doesn't fit
+static char * appendRecord(const char * filename, size_t len) {
+  char * recordStart = (char *)extapp_nextFree();
+  if (recordStart == NULL) {
+    return NULL;
   }
+  const char * storageEnd = (char *)(size_t)extapp_address() + extapp_size();
 
-  char * writableRecordStartPointer = (char *)extapp_nextFree();
-
-  // We have enough storage, so we can write the data
-  // Write size :
-  // size + filename + \0 + content
-  const uint16_t totalSize = 2 + strlen(filename) + 1 + len;
-  *(uint16_t *)writableRecordStartPointer = totalSize;
-
-  // Write filename:
-  memcpy(writableRecordStartPointer + 2, filename, strlen(filename) + 1);
+  // size + filename + \0 + content, and the zero size that ends the records
+  const size_t nameSize = strlen(filename) + 1;
+  const size_t totalSize = 2 + nameSize + len;
+  if (totalSize > UINT16_MAX || totalSize + 2 > (size_t)(storageEnd - recordStart)) {
+    return NULL;
+  }
 
-  // Write content:
-  memcpy(writableRecordStartPointer + 2 + strlen(filename) + 1, content, len);
+  const uint16_t size = totalSize;
+  memcpy(recordStart, &size, 2);
+  memcpy(recordStart + 2, filename, nameSize);
+  return recordStart + 2 + nameSize;
+}
 
-  // The record is now written, so we can return
+bool extapp_fileWrite(const char * filename, const char * content, size_t len) {
+  char * destination = appendRecord(filename, len);
+  if (destination == NULL) {
+    // Not enough free storage
+    return false;
+  }
+  memcpy(destination, content, len);
   return true;
 }
 
+char * extapp_fileReserve(const char * filename, size_t len) {
+  char * content = appendRecord(filename, len);
+  if (content != NULL) {
+    memset(content, 0, len);
+  }
+  return content;
+}
+
 bool extapp_fileErase(const char * filename) {
   uint32_t storageAddress = extapp_address();
-  char * offset = (char *)storageAddress;
-  const char * endAddress = (char *)extapp_size() + storageAddress;
+  char * offset = (char *)(uintptr_t)storageAddress;
+  const char * endAddress = (char *)(uintptr_t)storageAddress + extapp_size();
 
   if (!extapp_isValid((const uint32_t *)offset)) {
     // Storage is invalid
@@ -194,7 +213,7 @@ bool extapp_fileErase(const char * filename) {
   // Locate the record address
   char * recordAddress = NULL;
   while (offset < endAddress) {
-    uint16_t size = *(uint16_t *)offset;
+    uint16_t size = recordSize(offset);
     if (size == 0) {
       break;
     }
@@ -214,11 +233,11 @@ bool extapp_fileErase(const char * filename) {
   }
 
   // Get the file size
-  const uint16_t len =  *(uint16_t *)offset;
+  const uint16_t len = recordSize(offset);
 
-  // Move the rest of the data
+  // Move the records after it
   char * nextFree = (char *)extapp_nextFree();
-  memmove(offset, offset + len, nextFree - offset);
+  memmove(offset, offset + len, nextFree - (offset + len));
 
   // Overwrite the rest of the storage with zeroes
   memset(nextFree - len, 0, len);
@@ -227,6 +246,9 @@ bool extapp_fileErase(const char * filename) {
 }
 
 
+// On the host, these come from the fake storage of host/storage_host.c
+#ifndef NUMWORKS_HOST
+
 uint32_t extapp_address() {
   return *(uint32_t *)((*extapp_userlandAddress()) + 0xC);
 }
@@ -235,11 +257,13 @@ uint32_t extapp_size() {
   return *(uint32_t *)((*extapp_userlandAddress()) + 0x10);
 }
 
+#endif // NUMWORKS_HOST
+
 
 const uint32_t * extapp_nextFree() {
   uint32_t storageAddress = extapp_address();
-  char * offset = (char *)storageAddress;
-  const char * endAddress = (char *)extapp_size() + storageAddress;
+  char * offset = (char *)(uintptr_t)storageAddress;
+  const char * endAddress = (char *)(uintptr_t)storageAddress + extapp_size();
 
   if (!extapp_isValid((const uint32_t *)offset)) {
     // Storage is invalid
@@ -249,7 +273,7 @@ const uint32_t * extapp_nextFree() {
   offset += 4;
 
   while (offset < endAddress) {
-    uint16_t size = *(uint16_t *)offset;
+    uint16_t size = recordSize(offset);
     if (size == 0) {
       // Here, we are at the place where new records should start
       return (const uint32_t *)offset;
@@ -263,7 +287,7 @@ const uint32_t * extapp_nextFree() {
 }
 
 uint32_t extapp_used() {
-  return (uint32_t)extapp_nextFree() - extapp_address();
+  return (uint32_t)(size_t)extapp_nextFree() - extapp_address();
 }
 
 
@@ -271,6 +295,8 @@ bool extapp_isValid(const uint32_t * address) {
   return *address == reverse32(0xBADD0BEE);
 }
 
+#ifndef NUMWORKS_HOST
+
 uint8_t extapp_calculatorModel() {
   // To guess the storage size without reading forbidden addresses, we try to
   // get the storage address from the userland header
@@ -330,3 +356,5 @@ const uint32_t * extapp_userlandAddress() {
   // than N0110/N0115
   return (uint32_t *)0x24000008;
 }
+
+#endif // NUMWORKS_HOST
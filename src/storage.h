@@ -23,6 +23,9 @@ bool extapp_fileExists(const char * filename);
 const char * extapp_fileRead(const char * filename, size_t * len);
 bool extapp_fileWrite(const char * filename, const char * content, size_t len);
 bool extapp_fileErase(const char * filename);
+// Append a record of `len` zeroed bytes, and return a pointer to its content
+// (to be filled in place), or NULL if there isn't enough free storage
+char * extapp_fileReserve(const char * filename, size_t len);
 uint32_t extapp_size();
 uint32_t extapp_address();
 uint32_t extapp_used();
@@ -32,6 +35,11 @@ bool extapp_isValid(const uint32_t * address);
 uint8_t extapp_calculatorModel();
 const uint32_t * extapp_userlandAddress();
 
+#ifdef NUMWORKS_HOST
+// Host only: replace the fake storage by an empty one of `size` bytes
+void extapp_hostStorageReset(size_t size);
+#endif
+
 
 #ifdef __cplusplus
 }
@@ -3,11 +3,15 @@
 #include <stdlib.h> // For NULL, size_t, malloc, realloc
 #include <string.h> // For strcpy, strlen
 #include <stdio.h>  // For printf
+#include <stdbool.h>
 #include <eadk.h>   // For eadk_timing_msleep
 
 #define TCC_IS_NATIVE
 #include "libtcc.h" // for TCCState
 
+// The host C library already has these (and libtcc needs the real ones there)
+#ifndef NUMWORKS_HOST
+
 #define PATH_MAX 128
 
 // Define a simple realpath stub
@@ -131,6 +135,8 @@ int mprotect(void *addr, size_t len, int prot) {
 #define PROT_EXEC       0x4     /* pages can be executed */
 #endif
 
+#endif // NUMWORKS_HOST
+
 
 //
 // Custom realloc function
@@ -139,56 +145,239 @@ int mprotect(void *addr, size_t len, int prot) {
 
 #include <stdint.h> // For uint8_t
 #include <stddef.h> // For size_t
+#include "mem_pool.h"
+#include "tcc_stubs.h" // for tcc_numworks_heap_hook_t
+
+// The TCC heap is the high end of the memory pool (see mem_pool.h): it grows
+// down from the stack limit towards the newlib heap, so its size is whatever
+// free SRAM is left on this calculator model.
+
+// Print (and wait after) each allocation, for debugging on the calculator
+#ifndef TCC_HEAP_VERBOSE
+#define TCC_HEAP_VERBOSE 1
+#endif
 
-// Define the size of the TCC heap in bytes
-// This is the CRITICAL value you'll need to tune.
-// Start with a conservative size, e.g., 64KB (64 * 1024).
-// The maximum you can allocate here is the TOTAL remaining free SRAM
-// AFTER the NumWorks firmware and your app's core code/data.
-#define TCC_HEAP_SIZE (48 * 1024) // Example: 48KB
-// #define TCC_HEAP_SIZE 0           // Example: 0KB
+// Each block starts with a header holding its size, so that realloc can copy
+// the old content. It also keeps the payload aligned for doubles (8 bytes on ARM).
+#define TCC_HEAP_ALIGN (2 * sizeof(size_t))
 
-// Declare the TCC heap buffer
-// It's uninitialized, so it goes into .bss (saving flash space).
-static uint8_t s_tcc_heap_buffer[TCC_HEAP_SIZE];// = {0};
-static size_t s_tcc_heap_current_offset = 0; // Current allocation pointer for bump allocator
+typedef struct {
+    size_t size;    // Usable size of the block, in bytes
+    size_t tag;     // Serial of its allocation << 1, and TCC_BLOCK_FREED (also keeps the payload aligned)
+} tcc_block_header_t;
+
+// Bit of the tag set once TCC freed the block
+#define TCC_BLOCK_FREED 1
+
+static size_t s_tcc_heap_peak = 0;      // Highest usage since the last init
+static size_t s_tcc_heap_reclaimed = 0; // Bytes handed out again from freed blocks
+static size_t s_tcc_heap_reserve = 0;   // Free bytes of the pool kept out of reach
+static size_t s_tcc_heap_serial = 0;    // Allocations since the last init
+static tcc_numworks_heap_hook_t s_tcc_heap_hook = NULL;
+static tcc_numworks_heap_oom_t s_tcc_heap_oom = NULL;
 
 // Function to reset the heap (call before each TCC compilation session if needed)
 void tcc_numworks_heap_init() {
-    s_tcc_heap_current_offset = 0;
-    // // Optionally, clear the buffer for debugging
-    // memset(s_tcc_heap_buffer, 0, TCC_HEAP_SIZE);  // FIXME: this fails?
+    mem_pool_top_reset();
+    s_tcc_heap_peak = 0;
+    s_tcc_heap_reclaimed = 0;
+    s_tcc_heap_serial = 0;
+}
+
+// Everything the TCC heap could get: its current usage, and the free space of the pool
+size_t tcc_numworks_heap_size() {
+    return mem_pool_top_used() + mem_pool_free();
+}
+
+size_t tcc_numworks_heap_used() {
+    return mem_pool_top_used();
+}
+
+size_t tcc_numworks_heap_peak() {
+    return s_tcc_heap_peak;
+}
+
+size_t tcc_numworks_heap_reclaimed() {
+    return s_tcc_heap_reclaimed;
+}
+
+size_t tcc_numworks_heap_serial() {
+    return s_tcc_heap_serial;
+}
+
+void tcc_numworks_heap_set_hook(tcc_numworks_heap_hook_t hook) {
+    s_tcc_heap_hook = hook;
+}
+
+void tcc_numworks_heap_set_oom_handler(tcc_numworks_heap_oom_t handler) {
+    s_tcc_heap_oom = handler;
+}
+
+void tcc_numworks_heap_set_reserve(size_t size) {
+    s_tcc_heap_reserve = size;
+}
+
+// The blocks are packed from the start of the high end to the end of the pool,
+// each one right after the previous one's payload
+static tcc_block_header_t *tcc_heap_find_block(const void *address) {
+    uint8_t *block = mem_pool_top_start();
+    uint8_t *heap_end = block + mem_pool_top_used();
+    while (block < heap_end) {
+        tcc_block_header_t *header = (tcc_block_header_t *)block;
+        uint8_t *next = block + sizeof(tcc_block_header_t) + header->size;
+        if ((const uint8_t *)address >= (uint8_t *)(header + 1) && (const uint8_t *)address < next) {
+            return header;
+        }
+        block = next;
+    }
+    return NULL;
+}
+
+size_t tcc_numworks_heap_block_size(const void *address) {
+    tcc_block_header_t *header = tcc_heap_find_block(address);
+    return header != NULL ? header->size : 0;
+}
+
+size_t tcc_numworks_heap_block_serial(const void *address) {
+    tcc_block_header_t *header = tcc_heap_find_block(address);
+    return header != NULL ? header->tag >> 1 : 0;
+}
+
+static void tcc_heap_update_peak() {
+    if (mem_pool_top_used() > s_tcc_heap_peak) {
+        s_tcc_heap_peak = mem_pool_top_used();
+    }
+}
+
+static tcc_block_header_t *tcc_heap_header(void *ptr) {
+    return (tcc_block_header_t *)ptr - 1;
+}
+
+// Grow the heap by `size` bytes, unless that cuts into the reserve
+static void *tcc_heap_take(size_t size) {
+    size_t free_size = mem_pool_free();
+    if (free_size < s_tcc_heap_reserve || size > free_size - s_tcc_heap_reserve) {
+        return NULL;
+    }
+    return mem_pool_top_alloc(size);
+}
+
+// Give back the freed blocks at the end of the heap
+static void tcc_heap_trim() {
+    while (mem_pool_top_used() > 0) {
+        tcc_block_header_t *header = mem_pool_top_start();
+        if (!(header->tag & TCC_BLOCK_FREED)) {
+            break;
+        }
+        mem_pool_top_release(sizeof(tcc_block_header_t) + header->size);
+    }
 }
 
-// Your custom free for TCC (no-op for a bump allocator)
+// No room left at the end of the heap: merge the runs of blocks that TCC freed,
+// and reuse the first one that is big enough (split if enough is left over).
+// Live blocks can't move, since TCC holds pointers to them.
+static tcc_block_header_t *tcc_heap_reclaim(size_t aligned_size) {
+    uint8_t *block = mem_pool_top_start();
+    uint8_t *heap_end = block + mem_pool_top_used();
+    while (block < heap_end) {
+        tcc_block_header_t *header = (tcc_block_header_t *)block;
+        uint8_t *next = block + sizeof(tcc_block_header_t) + header->size;
+        if (header->tag & TCC_BLOCK_FREED) {
+            while (next < heap_end && (((tcc_block_header_t *)next)->tag & TCC_BLOCK_FREED)) {
+                header->size += sizeof(tcc_block_header_t) + ((tcc_block_header_t *)next)->size;
+                next = block + sizeof(tcc_block_header_t) + header->size;
+            }
+            if (header->size >= aligned_size) {
+                size_t left = header->size - aligned_size;
+                if (left >= sizeof(tcc_block_header_t) + TCC_HEAP_ALIGN) {
+                    tcc_block_header_t *rest = (tcc_block_header_t *)((uint8_t *)(header + 1) + aligned_size);
+                    rest->size = left - sizeof(tcc_block_header_t);
+                    rest->tag = TCC_BLOCK_FREED;
+                    header->size = aligned_size;
+                }
+                header->tag = s_tcc_heap_serial << 1;
+                s_tcc_heap_reclaimed += header->size;
+                return header;
+            }
+        }
+        block = next;
+    }
+    return NULL;
+}
+
+// The heap grows down, so the last block is the lowest one: the only one that
+// can grow or be given back right away
+static bool tcc_heap_is_last(void *ptr) {
+    return (void *)tcc_heap_header(ptr) == mem_pool_top_start();
+}
+
+// Your custom free for TCC
 void numworks_tcc_free(void *ptr) {
-    // In a bump allocator, memory is only reclaimed by resetting the `s_tcc_heap_current_offset`
-    // pointer (i.e., calling `tcc_numworks_heap_init()`)
-    printf("TCC_FREE: %p (no-op)\n", ptr);
+    // The last block is given back right away, with the freed blocks above
+    // it. The others are only marked, and reused when the heap is full (see
+    // tcc_heap_reclaim); the whole heap goes with `tcc_numworks_heap_init()`
+    if (ptr && mem_pool_top_contains(ptr)) {
+        if (tcc_heap_is_last(ptr)) {
+            mem_pool_top_release(sizeof(tcc_block_header_t) + tcc_heap_header(ptr)->size);
+            tcc_heap_trim();
+        } else {
+            tcc_heap_header(ptr)->tag |= TCC_BLOCK_FREED;
+        }
+    }
+#if TCC_HEAP_VERBOSE
+    printf("TCC_FREE: %p\n", ptr);
     eadk_timing_msleep(1000);
+#endif
 }
 
 // Your custom malloc for TCC
 void *numworks_tcc_malloc(size_t size) {
-    size_t aligned_size = (size + 3) & ~3; // Align to 4 bytes for ARM
-
-    if (s_tcc_heap_current_offset + aligned_size > TCC_HEAP_SIZE) {
-        // Out of memory within our designated TCC heap
-        // You MUST log this or display on screen for debugging
-        // For example:
-        printf("TCC_MALLOC FAIL: Req %iB, Free %iB\n", size, TCC_HEAP_SIZE - s_tcc_heap_current_offset);
-        eadk_timing_msleep(1000);
+    size_t aligned_size = (size + TCC_HEAP_ALIGN - 1) & ~(TCC_HEAP_ALIGN - 1);
+    tcc_block_header_t *header = NULL;
+    // Counted before the hook, which may look at it
+    s_tcc_heap_serial++;
+
+    // A block placed elsewhere by the hook isn't ours: free and realloc leave it alone
+    if (s_tcc_heap_hook != NULL && aligned_size >= size) {
+        void *foreign = s_tcc_heap_hook(aligned_size);
+        if (foreign != NULL) {
+            return foreign;
+        }
+    }
+
+    if (aligned_size < size) {
         return NULL;
     }
+    while (header == NULL) {
+        header = tcc_heap_take(sizeof(tcc_block_header_t) + aligned_size);
+        if (header != NULL) {
+            header->size = aligned_size;
+            header->tag = s_tcc_heap_serial << 1;
+            break;
+        }
+        // The TCC heap met the newlib heap: reuse freed blocks, or let the
+        // handler free some memory (or unwind the compilation, see oom.h)
+        header = tcc_heap_reclaim(aligned_size);
+        if (header == NULL && (s_tcc_heap_oom == NULL || !s_tcc_heap_oom(aligned_size))) {
+            // Out of memory
+            // You MUST log this or display on screen for debugging
+            // For example:
+            printf("TCC_MALLOC FAIL: Req %zuB, Free %zuB\n", size, mem_pool_free());
+            eadk_timing_msleep(1000);
+            return NULL;
+        }
+    }
 
-    void *ptr = &s_tcc_heap_buffer[s_tcc_heap_current_offset];
-    s_tcc_heap_current_offset += aligned_size;
+    tcc_heap_update_peak();
+    void *ptr = header + 1;
 
+#if TCC_HEAP_VERBOSE
     // Optional debug print
-    printf("TCC_MALLOC: Req %i (aligned %i)\n", size, aligned_size);
+    printf("TCC_MALLOC: Req %zu (aligned %zu)\n", size, aligned_size);
     eadk_timing_msleep(200);
-    printf("TCC_MALLOC: Got %p, Offset %i\n", ptr, s_tcc_heap_current_offset);
+    printf("TCC_MALLOC: Got %p, Used %zu\n", ptr, mem_pool_top_used());
     eadk_timing_msleep(200);
+#endif
     return ptr;
 }
 
@@ -201,28 +390,38 @@ void *numworks_tcc_realloc(void *ptr, size_t size) {
         numworks_tcc_free(ptr);
         return NULL;
     }
+    if (!mem_pool_top_contains(ptr)) {
+        // Not one of our blocks (allocated before tcc_set_realloc), so we
+        // don't know its size: the content can't be kept
+        return numworks_tcc_malloc(size);
+    }
+
+    tcc_block_header_t *header = tcc_heap_header(ptr);
+    if (size <= header->size) {
+        return ptr;
+    }
+
+    // TCC mostly grows its last allocated buffer: extend the heap by the
+    // difference and slide the block down, instead of leaving a hole
+    if (tcc_heap_is_last(ptr)) {
+        size_t aligned_size = (size + TCC_HEAP_ALIGN - 1) & ~(TCC_HEAP_ALIGN - 1);
+        size_t old_size = header->size;
+        tcc_block_header_t *new_header = NULL;
+        if (aligned_size >= size) {
+            new_header = tcc_heap_take(aligned_size - old_size);
+        }
+        if (new_header != NULL) {
+            memmove(new_header, header, sizeof(tcc_block_header_t) + old_size);
+            new_header->size = aligned_size;
+            tcc_heap_update_peak();
+            return new_header + 1;
+        }
+    }
 
-    // Simplistic realloc for bump allocator: always reallocate and copy.
-    // This can be inefficient and cause fragmentation if used heavily
-    // on non-last-allocated blocks, but it's a starting point.
     void *new_ptr = numworks_tcc_malloc(size);
-    if (new_ptr && ptr) {
-        // We don't know the old size of 'ptr', so we must assume
-        // TCC will copy the necessary data from the old pointer.
-        // Or, more safely, copy up to `size` bytes, assuming new_ptr is larger.
-        // If TCC needs the old content, it will handle it.
-        // This is a *major simplification* due to the bump allocator.
-        // For a robust realloc, you'd need a more complex allocator.
-        // For now, if TCC expects data preservation, this will fail.
-        // A safer approach might be to just return new_ptr; and let TCC
-        // copy if it needs.
-        // However, typical TCC usage of realloc is for growing its internal buffers,
-        // so a simple copy-up-to-new-size might sometimes work.
-        // For simplicity, let's just allocate and return for now,
-        // if TCC needs to preserve data, it will crash or behave incorrectly.
-        // memmove(new_ptr, ptr, MIN(old_size, size)); // Would need old_size
-        // For a pure bump allocator, no real "move" happens, just new allocation.
-        // We'll rely on TCC internal logic not to require the contents to be copied by realloc for now.
+    if (new_ptr) {
+        memcpy(new_ptr, ptr, header->size);
+        numworks_tcc_free(ptr);
     }
     return new_ptr;
 }
@@ -3,6 +3,7 @@
 #include <stdlib.h> // For NULL, size_t
 #include <string.h> // For strcpy
 #include <stdint.h> // For strcpy
+#include <stdbool.h>
 
 #define TCC_IS_NATIVE
 #include "libtcc.h" // for TCCState
@@ -27,12 +28,34 @@ int mprotect(void *addr, size_t len, int prot);
 // numworks_tcc_heap.h
 #include <stddef.h> // For size_t
 
-// The TCC heap buffer (defined in tcc_stubs.c file)
-extern uint8_t tcc_heap_buffer[];
-extern size_t tcc_heap_current_offset;
-extern const size_t TCC_HEAP_SIZE; // Make this visible too
+// The TCC heap buffer is defined in tcc_stubs.c file
 
 void tcc_numworks_heap_init() ;
+// Size, current usage and peak usage (since the last init) of the TCC heap, in bytes
+size_t tcc_numworks_heap_size() ;
+size_t tcc_numworks_heap_used() ;
+size_t tcc_numworks_heap_peak() ;
+// Usable size of the heap block holding `address`, or 0 if it's not in one
+size_t tcc_numworks_heap_block_size(const void *address) ;
+// Number of allocations since the last init: inside the hook, the serial of
+// the allocation being made
+size_t tcc_numworks_heap_serial() ;
+// Serial of the allocation that made the heap block holding `address` (1 for
+// the first one since the last init), or 0 if it's not in one
+size_t tcc_numworks_heap_block_serial(const void *address) ;
+// Called first by each allocation, with the aligned size: a non-NULL result is
+// given to TCC instead of a heap block (NULL hook to remove it)
+typedef void *(*tcc_numworks_heap_hook_t)(size_t aligned_size);
+void tcc_numworks_heap_set_hook(tcc_numworks_heap_hook_t hook) ;
+// Called when an allocation doesn't fit, even in the blocks freed by TCC: it
+// returns true once it freed some memory, to have the allocation tried again
+// (NULL handler to remove it)
+typedef bool (*tcc_numworks_heap_oom_t)(size_t aligned_size);
+void tcc_numworks_heap_set_oom_handler(tcc_numworks_heap_oom_t handler) ;
+// Keep `size` free bytes of the pool out of reach of the TCC heap
+void tcc_numworks_heap_set_reserve(size_t size) ;
+// Bytes handed out again from blocks freed by TCC, since the last init
+size_t tcc_numworks_heap_reclaimed() ;
 void *numworks_tcc_malloc(size_t size) ;
 void *numworks_tcc_realloc(void *ptr, size_t size) ;
 void numworks_tcc_free(void *ptr) ;
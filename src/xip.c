@@ -0,0 +1,163 @@
+//
+// Run the compiled program from a storage record (see xip.h)
+//
+#include "xip.h"
+#include "tcc_stubs.h"
+#include "jit_exports.h"
+#include "mem_pool.h"
+#include "oom.h"
+#include "storage.h"
+#include <stdint.h>
+#include <string.h>
+
+// The image block is handed out once, to the allocation of tcc_relocate() that
+// made the image in the first pass: the one with the same rank and size
+static char * s_xip_slot = NULL;
+static size_t s_xip_slot_size = 0;
+static size_t s_xip_slot_rank = 0;      // 1 for the first allocation of tcc_relocate()
+static size_t s_xip_relocate_serial = 0; // Heap serial when tcc_relocate() started
+
+static void * xip_hook(size_t aligned_size) {
+  if (s_xip_slot == NULL || aligned_size != s_xip_slot_size ||
+      tcc_numworks_heap_serial() - s_xip_relocate_serial != s_xip_slot_rank) {
+    return NULL;
+  }
+  void * slot = s_xip_slot;
+  s_xip_slot = NULL;
+  return slot;
+}
+
+// Reserve the record for an image of `image_size` bytes, and return where the
+// image goes: the record content isn't aligned, so it keeps room to align it
+static char * xip_reserve(size_t image_size) {
+  extapp_fileErase(XIP_RECORD_NAME);
+  char * content = extapp_fileReserve(XIP_RECORD_NAME, image_size + MEM_POOL_ALIGN);
+  if (content == NULL) {
+    return NULL;
+  }
+  return (char *)(((uintptr_t)content + MEM_POOL_ALIGN - 1) & ~(uintptr_t)(MEM_POOL_ALIGN - 1));
+}
+
+// True if the record still starts where xip_reserve() put it: erasing a
+// record stored before it moves it (see xip.h)
+static bool xip_in_place(const char * image) {
+  size_t length = 0;
+  const char * content = extapp_fileRead(XIP_RECORD_NAME, &length);
+  return content != NULL && image >= content && (size_t)(image - content) < MEM_POOL_ALIGN;
+}
+
+// Drop the image block and the hook, left armed if a build was unwound
+static void xip_disarm(void) {
+  tcc_numworks_heap_set_hook(NULL);
+  s_xip_slot = NULL;
+}
+
+// Same steps as main(). With `place`, the record is reserved once the program
+// is compiled (so that no header of the cache is open while the records move),
+// and the hook is armed around tcc_relocate().
+static TCCState * xip_compile(const char * source, bool helpers, TCCErrorFunc error_func, void * error_opaque,
+                              bool place, xip_report_t * report) {
+  oom_phase("new", false);
+  tcc_numworks_heap_init();
+  tcc_set_realloc(numworks_tcc_realloc);
+  TCCState * tcc_state = tcc_new();
+  if (!tcc_state) {
+    report->failed = "compile";
+    return NULL;
+  }
+#ifdef HOST_TCC_LIB_PATH
+  tcc_set_lib_path(tcc_state, HOST_TCC_LIB_PATH);
+#endif
+  tcc_set_error_func(tcc_state, error_opaque, error_func);
+  tcc_set_output_type(tcc_state, TCC_OUTPUT_MEMORY);
+  oom_phase("compile", true);
+  if (jit_add_bundle(tcc_state, helpers) == -1 || tcc_compile_string(tcc_state, source) == -1) {
+    report->failed = "compile";
+    tcc_delete(tcc_state);
+    return NULL;
+  }
+  oom_phase("symbols", false);
+  jit_add_symbols(tcc_state);
+
+  if (place) {
+    s_xip_slot = xip_reserve(report->image_size);
+    if (s_xip_slot == NULL) {
+      report->failed = "storage";
+      tcc_delete(tcc_state);
+      return NULL;
+    }
+    s_xip_slot_size = report->image_size;
+    report->record = s_xip_slot;
+    tcc_numworks_heap_set_hook(xip_hook);
+  }
+  oom_phase("relocate", false);
+  s_xip_relocate_serial = tcc_numworks_heap_serial();
+  int relocated = tcc_relocate(tcc_state);
+  tcc_numworks_heap_set_hook(NULL);
+  if (relocated < 0) {
+    report->failed = "relocate";
+    tcc_delete(tcc_state);
+    return NULL;
+  }
+  return tcc_state;
+}
+
+runner_main_t xip_build(const char * source, bool helpers, TCCErrorFunc error_func, void * error_opaque,
+                        xip_report_t * report) {
+  memset(report, 0, sizeof(*report));
+  xip_disarm();
+
+  // First pass: relocate in the heap, to find the block holding main(), and
+  // which allocation of tcc_relocate() made it
+  TCCState * tcc_state = xip_compile(source, helpers, error_func, error_opaque, false, report);
+  if (tcc_state == NULL) {
+    return NULL;
+  }
+  runner_main_t entry = (runner_main_t)tcc_get_symbol(tcc_state, "main");
+  size_t serial = entry ? tcc_numworks_heap_block_serial((const void *)entry) : 0;
+  report->image_size = entry ? tcc_numworks_heap_block_size((const void *)entry) : 0;
+  tcc_delete(tcc_state);
+  tcc_numworks_heap_init();
+  if (!entry) {
+    report->failed = "no-main";
+    return NULL;
+  }
+  if (report->image_size == 0 || serial <= s_xip_relocate_serial) {
+    // main() isn't in a block allocated by tcc_relocate(): this libtcc doesn't
+    // allocate its image with tcc_malloc
+    report->failed = "image";
+    return NULL;
+  }
+  s_xip_slot_rank = serial - s_xip_relocate_serial;
+
+  // Second pass: the same program gives the same allocations, and the image
+  // is relocated in the record
+  tcc_state = xip_compile(source, helpers, error_func, error_opaque, true, report);
+  bool placed = s_xip_slot == NULL;
+  s_xip_slot = NULL;
+  if (tcc_state == NULL) {
+    xip_release();
+    return NULL;
+  }
+  entry = (runner_main_t)tcc_get_symbol(tcc_state, "main");
+  report->heap_peak = tcc_numworks_heap_peak();
+  if (!placed || !xip_in_place(report->record) || (const char *)entry < report->record ||
+      (const char *)entry >= report->record + report->image_size) {
+    report->failed = "placement";
+    tcc_delete(tcc_state);
+    tcc_numworks_heap_init();
+    xip_release();
+    return NULL;
+  }
+
+  // Freeing the image is a no-op since it's not a heap block, so the program
+  // outlives the state, and the whole heap is free for its run
+  tcc_delete(tcc_state);
+  tcc_numworks_heap_init();
+  return entry;
+}
+
+void xip_release(void) {
+  xip_disarm();
+  extapp_fileErase(XIP_RECORD_NAME);
+}
@@ -0,0 +1,64 @@
+//
+// Run the compiled program from a storage record instead of the TCC heap
+//
+// After tcc_relocate(), the program image stays in the TCC heap for the whole
+// run, next to everything TCC allocated while compiling. With TCC_XIP, the
+// image is relocated straight into a record of the storage (see storage.h),
+// so the TCC state can be deleted and the whole heap freed before the run.
+//
+// libtcc lays its image out as a single block (text, rodata, data and bss),
+// so the record holds all of it. Its size is only known once the program is
+// relocated, so the program is compiled twice: once in the heap to measure the
+// image, once with the image block placed in the record. The second pass gives
+// the record to the allocation of tcc_relocate() with the same rank (see
+// tcc_numworks_heap_serial()) and size as the image of the first pass.
+//
+// The program runs from the record, at a fixed address: erasing a record stored
+// before it (like extapp_fileErase() of an older record) moves every record
+// after it, and the running image with them. So from xip_build() to
+// xip_release(), only records stored after it may be erased. xip_build()
+// checks that the record is still in place once the image is relocated.
+//
+#ifndef XIP_H
+#define XIP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "libtcc.h" // for TCCErrorFunc
+#include "runner.h" // for runner_main_t
+
+// Build the program with its image in the storage record
+#ifndef TCC_XIP
+#define TCC_XIP 0
+#endif
+
+// Name of the record holding the image (replaced on each build)
+#define XIP_RECORD_NAME "tcc.xip"
+
+typedef struct {
+  size_t image_size;   // Size of the image block, in bytes
+  const char * record; // Start of the image in the record
+  size_t heap_peak;    // TCC heap peak of the second compilation
+  const char * failed; // Step that failed ("compile", "relocate", "no-main", "image", "storage", "placement"), or NULL
+} xip_report_t;
+
+// Compile `source` (with the helper library of the bundle if `helpers`) and
+// relocate it into the record, then delete the TCC state. Returns the main()
+// of the program, or NULL (see report->failed). It names its phases for
+// oom_run() (see oom.h), which may unwind it: the next xip_build() or
+// xip_release() cleans up after that.
+runner_main_t xip_build(const char * source, bool helpers, TCCErrorFunc error_func, void * error_opaque,
+                        xip_report_t * report);
+
+// Erase the record, once the program is done or its build given up
+void xip_release(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif